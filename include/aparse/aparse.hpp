@@ -7,3 +7,6 @@
 #include "aparse/parser.hpp"
 #include "aparse/parser_builder.hpp"
 #include "aparse/lexer_builder.hpp"
+#include "aparse/parallel_lexer.hpp"
+#include "aparse/batch_lexer.hpp"
+#include "aparse/incremental_lexer.hpp"
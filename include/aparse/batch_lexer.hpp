@@ -0,0 +1,50 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#ifndef APARSE_BATCH_LEXER_HPP_
+#define APARSE_BATCH_LEXER_HPP_
+
+#include <vector>
+
+#include "aparse/error.hpp"
+#include "aparse/lexer.hpp"
+#include "aparse/utils/string_view.hpp"
+
+namespace aparse {
+
+/** Lexes many small independent inputs on a single thread, in the
+ *  token-buffer mode (refer to Lexer::CreateInstance(scope, token_buffer)).
+ *  Lexing an input is a chain of dependent loads from the transition table,
+ *  one per byte, so a single input keeps the core stalled on memory. Here
+ *  `kNumLanes` inputs are advanced in lockstep, one byte of each per round,
+ *  so that their loads overlap. A lane picks the next pending input as soon
+ *  as it's done with its current one.
+ *  The output of each input is identical to the one of
+ *  LexerInstance::Feed followed by LexerInstance::End.
+ *  Like ParallelLexer, the whole input is lexed in the main section. Lexers
+ *  having rules with JumpTo to the other sections are not supported: every
+ *  input fails with LEXER_ERROR_UNSUPPORTED_SECTIONS. */
+class BatchLexer {
+ public:
+  explicit BatchLexer(const Lexer& lexer);
+
+  /** Lex each of the @inputs, appending its tokens into (*outputs)[i], and
+   *  set (*errors)[i] to its error, if any. @outputs must have one token
+   *  buffer per input.
+   *  @returns false if any of the inputs failed. */
+  bool LexBatch(const std::vector<utils::string_view>& inputs,
+                std::vector<TokenBuffer>* outputs,
+                std::vector<Error>* errors) const;
+
+  static constexpr int kNumLanes = 12;
+
+ private:
+  // not owned.
+  const Lexer* lexer;
+  // true if any rule jumps to a section other than the main one.
+  bool uses_sections = false;
+};
+
+}  // namespace aparse
+
+#endif  // APARSE_BATCH_LEXER_HPP_
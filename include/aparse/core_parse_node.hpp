@@ -42,18 +42,17 @@ namespace aparse {
 struct CoreParseNode {
   CoreParseNode() {}
   explicit CoreParseNode(int label): label(label) {}
-  CoreParseNode(int label, int start): label(label), start(start) {}
-  CoreParseNode(int label, const pair<int, int>& range): label(label),
-                                                         start(range.first),
-                                                         end(range.second) {}
+  CoreParseNode(int label, Offset start): label(label), start(start) {}
+  CoreParseNode(int label, const pair<Offset, Offset>& range)
+       : label(label), start(range.first), end(range.second) {}
   CoreParseNode(int label,
-                const pair<int, int>& range,
+                const pair<Offset, Offset>& range,
                 const vector<CoreParseNode>& children): label(label),
                                                         start(range.first),
                                                         end(range.second),
                                                         children(children) {}
   CoreParseNode(int label,
-                const pair<int, int>& range,
+                const pair<Offset, Offset>& range,
                 vector<CoreParseNode>&& children)
        : label(label),
          start(range.first),
@@ -67,7 +66,7 @@ struct CoreParseNode {
   /** Currently this label represents the index of matching rule in
    *  AParseGrammar. Rule are numbered 0, 1, 2,... ...(num_rules - 1) */
   int label = 0;
-  int start = 0, end = 0;  // start: inclusive, end: exclusive;
+  Offset start = 0, end = 0;  // start: inclusive, end: exclusive;
   vector<CoreParseNode> children;
 };
 
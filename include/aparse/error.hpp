@@ -24,9 +24,14 @@ struct Error: public std::exception {
                     LEXER_BUILDER_ERROR,
                     LEXER_BUILDER_ERROR_INVALID_REGEX,
                     LEXER_BUILDER_ERROR_MUST_HAVE_NON_ZERO_RULES,
+                    LEXER_BUILDER_ERROR_INVALID_KEYWORD,
+                    LEXER_BUILDER_ERROR_INVALID_SECTION,
                     LEXER_ERROR,
                     LEXER_ERROR_INVALID_TOKENS,
                     LEXER_ERROR_INCOMPLETE_TOKENS,
+                    LEXER_ERROR_TOKEN_BUFFER_FULL,
+                    LEXER_ERROR_INPUT_READ_FAILED,
+                    LEXER_ERROR_UNSUPPORTED_SECTIONS,
 
                     INTERNAL_GRAMMAR_REGEX_LABEL_MUST_BE_ZERO,
                     GRAMMAR_INVALID_USE_OF_BRANCHING_ALPHABET,
@@ -53,7 +58,7 @@ struct Error: public std::exception {
   ErrorStatus status = SUCCESS;
   string error_message;
   std::string string_value;
-  pair<int, int> error_position;
+  pair<Offset, Offset> error_position;
   unordered_set<Alphabet> possible_alphabets;
   Error() {}
   explicit Error(ErrorStatus status): status(status) {this->operator()();}
@@ -92,7 +97,7 @@ struct Error: public std::exception {
     return *this;
   }
 
-  Error& Position(pair<int, int> error_position) {
+  Error& Position(pair<Offset, Offset> error_position) {
     this->error_position = error_position;
     return *this;
   }
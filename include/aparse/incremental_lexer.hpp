@@ -0,0 +1,85 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#ifndef APARSE_INCREMENTAL_LEXER_HPP_
+#define APARSE_INCREMENTAL_LEXER_HPP_
+
+#include <string>
+#include <vector>
+
+#include "aparse/error.hpp"
+#include "aparse/lexer.hpp"
+#include "aparse/utils/string_view.hpp"
+
+namespace aparse {
+
+/** Keeps the token stream of a text up to date across the edits of the
+ *  text, eg: the buffer of an editor.
+ *  Every token records the section it was lexed in, hence its DFA entry
+ *  state. An edit is re-lexed from the first token which could be affected
+ *  by it, and only until a token boundary of the new stream coincides with
+ *  the start of an old token after the edit, in the same section: from there
+ *  onwards the old tokens are valid as they are, since the lexer DFA is
+ *  deterministic.
+ *  Lexing is in the token-buffer mode (refer to
+ *  Lexer::CreateInstance(scope, token_buffer)), except that the tokens of
+ *  the skip rules are kept too. Rule actions are not invoked; sections are
+ *  switched by the JumpTo of the rules (LexerGrammar::Rule::JumpTo).
+ *  In case of invalid or incomplete tokens, the token stream covers the text
+ *  only up to the failed token (refer to `complete()`). */
+class IncrementalLexer {
+ public:
+  struct Token {
+    Offset start, end;
+    Alphabet token_id;
+    bool skip;
+    // Index of the section (in `Lexer::sections`) the token was lexed in.
+    int32_t section;
+  };
+
+  /** The tokens [begin, begin + num_removed) of the old token stream were
+   *  replaced by the tokens [begin, begin + num_inserted) of the new one.
+   *  The tokens after them are the same, shifted by the change in the length
+   *  of the text. */
+  struct Change {
+    size_t begin = 0, num_removed = 0, num_inserted = 0;
+  };
+
+  explicit IncrementalLexer(const Lexer& lexer);
+
+  /** Replace the whole text with @text, and lex it. */
+  bool Reset(utils::string_view text, Change* change, Error* error);
+
+  /** Replace the @removed_length bytes of the text at @offset with
+   *  @inserted_text, and re-lex the affected tokens.
+   *  @returns false if the new token stream is not complete, with the error
+   *  of the failed token in @error. */
+  bool Edit(size_t offset, size_t removed_length,
+            utils::string_view inserted_text, Change* change, Error* error);
+
+  const std::string& text() const {
+    return text_;
+  }
+  const std::vector<Token>& tokens() const {
+    return tokens_;
+  }
+  /** false iff lexing failed at the offset `tokens().back().end` (or 0). */
+  bool complete() const {
+    return complete_;
+  }
+
+ private:
+  // not owned.
+  const Lexer* lexer;
+  std::string text_;
+  std::vector<Token> tokens_;
+  bool complete_ = true;
+  // Error of the failed token, and the section it was lexed in, if the
+  // token stream is not complete.
+  Error error_;
+  int32_t failed_section = 0;
+};
+
+}  // namespace aparse
+
+#endif  // APARSE_INCREMENTAL_LEXER_HPP_
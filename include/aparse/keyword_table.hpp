@@ -0,0 +1,108 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#ifndef APARSE_KEYWORD_TABLE_HPP_
+#define APARSE_KEYWORD_TABLE_HPP_
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "quick/byte_stream.hpp"
+
+#include "aparse/common_headers.hpp"
+
+namespace aparse {
+
+/** Minimal perfect hash table of a fixed set of keywords, each mapped to a
+ *  label. Used for reclassifying the lexeme of an identifier rule into its
+ *  keyword rule, so that the keywords don't need to be expanded into the
+ *  lexer DFA.
+ *  A lexeme is hashed once. Its bucket's displacement then selects the only
+ *  slot the lexeme can be at, and it's compared with the keyword of that
+ *  slot, 16 bytes at a time where SSE2 is available. */
+class KeywordTable {
+ public:
+  /** Build the table of the (keyword, label) pairs. Keywords must be unique
+   *  and non-empty, labels must be positive. */
+  void Build(const std::vector<std::pair<std::string, int>>& keywords);
+
+  /** @returns the label of the keyword [text, text+len), or 0 if it's not a
+   *  keyword. */
+  int Find(const char* text, size_t len) const {
+    if (len < min_length || len > max_length) {
+      return 0;
+    }
+    uint64_t hash = Hash(text, len);
+    int slot = Slot(hash, displacements[hash % displacements.size()]);
+    if (lengths[slot] != len) {
+      return 0;
+    }
+    if (not Equal(text, &keywords[slot * stride], len)) {
+      return 0;
+    }
+    return labels[slot];
+  }
+
+  bool empty() const {
+    return labels.empty();
+  }
+  size_t size() const {
+    return labels.size();
+  }
+  size_t MaxLength() const {
+    return max_length;
+  }
+
+  void Serialize(quick::OByteStream& bs) const {  // NOLINT
+    bs << displacements << labels << lengths << keywords << stride
+       << min_length << max_length;
+  }
+  void Deserialize(quick::IByteStream& bs) {  // NOLINT
+    bs >> displacements >> labels >> lengths >> keywords >> stride
+       >> min_length >> max_length;
+  }
+
+ private:
+  static uint64_t Mix(uint64_t x) {
+    x = (x ^ (x >> 31)) * 0x7fb5d329728ea185ULL;
+    x = (x ^ (x >> 27)) * 0x81dadef4bc2dd44dULL;
+    return x ^ (x >> 33);
+  }
+
+  static uint64_t Hash(const char* text, size_t len) {
+    uint64_t hash = len * 0x9e3779b97f4a7c15ULL;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+      uint64_t word;
+      std::memcpy(&word, text + i, 8);
+      hash = Mix(hash ^ word);
+    }
+    uint64_t word = 0;
+    std::memcpy(&word, text + i, len - i);
+    return Mix(hash ^ word);
+  }
+
+  int Slot(uint64_t hash, uint32_t displacement) const {
+    return Mix(hash + displacement) % labels.size();
+  }
+
+  // Compares [text, text+len) with the zero padded @keyword, of the same
+  // length.
+  static bool Equal(const char* text, const char* keyword, size_t len);
+
+  // displacements[hash % size] is the displacement of the bucket.
+  std::vector<uint32_t> displacements;
+  // labels[slot], lengths[slot] and keywords[slot * stride ...] are the
+  // label, the length and the zero padded bytes of the keyword at the slot.
+  std::vector<int> labels;
+  std::vector<uint32_t> lengths;
+  std::vector<char> keywords;
+  uint32_t stride = 0;
+  uint32_t min_length = 1, max_length = 0;
+};
+
+}  // namespace aparse
+
+#endif  // APARSE_KEYWORD_TABLE_HPP_
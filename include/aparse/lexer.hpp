@@ -4,6 +4,7 @@
 #ifndef APARSE_LEXER_HPP_
 #define APARSE_LEXER_HPP_
 
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -14,165 +15,574 @@
 
 #include "aparse/common_headers.hpp"
 #include "aparse/error.hpp"
+#include "aparse/keyword_table.hpp"
+#include "aparse/lexer_input.hpp"
 #include "aparse/lexer_machine.hpp"
 #include "aparse/utils/any.hpp"
+#include "aparse/utils/string_view.hpp"
 
 namespace aparse {
 
 struct LexerScopeBase {
   struct LexingConstructs {
-    pair<int, int> range;
-    uint32_t line_number = 1;
-    uint32_t column_number = 0;
+    pair<Offset, Offset> range;
+    // Text of the token in `range`. Refer to Text().
+    utils::string_view text;
+    // Index of the section (in `Lexer::sections`) of the next token.
     int next_section;
+    // section_indexes[id - min_section_id] is the index of the section `id`,
+    // or -1. Not owned.
+    const int32_t* section_indexes = nullptr;
+    int32_t min_section_id = 0;
+    uint32_t num_section_ids = 0;
+
+    // Line and column numbers are computed lazily, only when asked for.
+    // `line_number` and `column_number` are the position of the byte at
+    // offset `synced_offset`.
+    mutable uint32_t line_number = 1;
+    mutable uint32_t column_number = 0;
+    mutable Offset synced_offset = 0;
+    // Summary of the bytes [synced_offset, position_chunk_offset), which
+    // belong to the released chunks: number of new lines in them, and the
+    // number of bytes after the last of them (or all the bytes, if none).
+    mutable uint32_t pending_lines = 0;
+    mutable uint32_t pending_column = 0;
+    // The chunk being fed and the offset of its first byte. Not owned.
+    const char* chunk = nullptr;
+    Offset chunk_offset = 0;
+    // The chunk being fed, [position_chunk_offset, position_chunk_end).
+    // Its new lines are counted only if a position is asked for, or when
+    // it's released at the end of Feed. Not owned.
+    mutable const char* position_chunk = nullptr;
+    mutable Offset position_chunk_offset = 0;
+    Offset position_chunk_end = 0;
+    // Start of the unfinished token at the end of the chunk.
+    Offset position_token_start = 0;
+
+    // Advance `line_number` and `column_number` upto the byte @offset.
+    // @offset must not be less than `synced_offset`, and the bytes
+    // [position_chunk_offset, offset) must be in `position_chunk`.
+    void SyncPosition(Offset offset) const;
+    // Called once the chunk is fed upto @chunk_end, before Feed returns.
+    // The chunk is released, see ReleaseChunk.
+    void EndChunk(Offset token_start, Offset chunk_end);
+    // The position is synced upto the start of the unfinished token, and
+    // the rest of the chunk is summarized in `pending_lines` and
+    // `pending_column`, so that the chunk isn't read anymore.
+    void ReleaseChunk();
+    void ResetPosition();
   };
-  pair<int, int> Range() const {
+  pair<Offset, Offset> Range() const {
     return __lexing_constructs.range;
   }
+  /** Text of the current token, without copying it: it points into the
+   *  input fed to the lexer, hence valid until that chunk of input is
+   *  released (eg: the next chunk of a LexerInputSource is read).
+   *  The tokens straddling the chunks are the exception; their text is
+   *  gathered in a buffer of the LexerInstance, valid until the next token. */
+  utils::string_view Text() const {
+    return __lexing_constructs.text;
+  }
   uint32_t LineNumber() const {
+    __lexing_constructs.SyncPosition(__lexing_constructs.range.first);
     return __lexing_constructs.line_number;
   }
   uint32_t ColumnNumber() const {
+    __lexing_constructs.SyncPosition(__lexing_constructs.range.first);
     return __lexing_constructs.column_number;
   }
   void JumpTo(int next_section) {
-    __lexing_constructs.next_section = next_section;
+    auto& lexing_constructs = __lexing_constructs;
+    uint32_t i = next_section - lexing_constructs.min_section_id;
+    APARSE_ASSERT(i < lexing_constructs.num_section_ids &&
+                  lexing_constructs.section_indexes[i] >= 0,
+                  "Invalid lexer section: " << next_section);
+    lexing_constructs.next_section = lexing_constructs.section_indexes[i];
   }
   LexingConstructs __lexing_constructs;
 };
 
 class Lexer;
 
-template<typename LexerScope = LexerScopeBase>
+/** An ActionTable is the policy used by LexerInstance for consuming the
+ *  recognised tokens: `bool Invoke(int label, LexerScope* scope)` is called
+ *  for each token, with the token's range in `scope`. It returns false if
+ *  the token could not be consumed, in which case the lexing stops before
+ *  this token.
+ *
+ *  Default action table of LexerInstance. Rule actions are type-erased
+ *  (utils::any holding a std::function<void(LexerScope*)>) and indexed by
+ *  label in `Lexer::actions`. */
+template<typename LexerScope>
+class AnyActionTable {
+ public:
+  AnyActionTable() = default;
+  AnyActionTable(const std::vector<utils::any>* actions,
+                 const std::vector<uint8_t>* has_action)
+  : actions(actions), has_action(has_action) {}
+
+  bool Invoke(int label, LexerScope* scope) const {
+    using ActionType = std::function<void(LexerScope*)>;
+    if ((*has_action)[label]) {
+      auto& action = (*actions)[label];
+      if (action.can_cast_to<ActionType>()) {
+        action.cast_to<ActionType>()(scope);
+      } else {
+        throw Error(Error::INVALID_LEXER_RUN_ACTION_TYPE);
+      }
+    }
+    return true;
+  }
+
+ private:
+  // not owned.
+  const std::vector<utils::any>* actions = nullptr;
+  const std::vector<uint8_t>* has_action = nullptr;
+};
+
+/** Action table of TypedLexer: actions of the concrete type `Action`, stored
+ *  in a vector indexed by label. */
+template<typename LexerScope, typename Action>
+class DenseActionTable {
+ public:
+  DenseActionTable() = default;
+  explicit DenseActionTable(const std::vector<Action>* actions)
+  : actions(actions) {}
+
+  bool Invoke(int label, LexerScope* scope) const {
+    (*actions)[label](scope);
+    return true;
+  }
+
+ private:
+  // not owned.
+  const std::vector<Action>* actions = nullptr;
+};
+
+/** Struct-of-arrays list of tokens, filled by the lexer in the token-buffer
+ *  mode. The i'th token is (token_ids()[i], starts()[i], ends()[i]), where
+ *  [start, end) is the range of the token in the input.
+ *  The capacity is fixed: either reserved by `Reserve` or provided by the
+ *  caller by `Attach`. Lexing fails with LEXER_ERROR_TOKEN_BUFFER_FULL once
+ *  it's full; it can be resumed after draining the buffer by `Clear`. */
+class TokenBuffer {
+ public:
+  TokenBuffer() = default;
+  explicit TokenBuffer(size_t capacity) {
+    Reserve(capacity);
+  }
+  TokenBuffer(const TokenBuffer&) = delete;
+  TokenBuffer& operator=(const TokenBuffer&) = delete;
+  TokenBuffer(TokenBuffer&&) = default;
+  TokenBuffer& operator=(TokenBuffer&&) = default;
+
+  /** Allocate the storage for @capacity tokens. Clears the buffer. */
+  void Reserve(size_t capacity) {
+    owned_token_ids.assign(capacity, 0);
+    owned_starts.assign(capacity, 0);
+    owned_ends.assign(capacity, 0);
+    Attach(owned_token_ids.data(), owned_starts.data(), owned_ends.data(),
+           capacity);
+  }
+
+  /** Use the caller provided arrays, each of size @capacity. Not owned.
+   *  Clears the buffer. */
+  void Attach(Alphabet* token_ids, Offset* starts, Offset* ends,
+              size_t capacity) {
+    token_ids_ = token_ids;
+    starts_ = starts;
+    ends_ = ends;
+    capacity_ = capacity;
+    size_ = 0;
+  }
+
+  inline bool Append(Alphabet token_id, Offset start, Offset end) {
+    if (size_ == capacity_) {
+      return false;
+    }
+    token_ids_[size_] = token_id;
+    starts_[size_] = start;
+    ends_[size_] = end;
+    size_++;
+    return true;
+  }
+
+  void Clear() {
+    size_ = 0;
+  }
+  size_t size() const {
+    return size_;
+  }
+  size_t capacity() const {
+    return capacity_;
+  }
+  bool full() const {
+    return size_ == capacity_;
+  }
+  const Alphabet* token_ids() const {
+    return token_ids_;
+  }
+  const Offset* starts() const {
+    return starts_;
+  }
+  const Offset* ends() const {
+    return ends_;
+  }
+
+  /** The token ids, as an alphabet stream for ParserInstance::Feed. */
+  std::vector<Alphabet> Alphabets() const {
+    return std::vector<Alphabet>(token_ids_, token_ids_ + size_);
+  }
+
+ private:
+  std::vector<Alphabet> owned_token_ids;
+  std::vector<Offset> owned_starts, owned_ends;
+  Alphabet* token_ids_ = nullptr;
+  Offset* starts_ = nullptr;
+  Offset* ends_ = nullptr;
+  size_t size_ = 0, capacity_ = 0;
+};
+
+/** Action table of the token-buffer mode: no rule action is invoked, every
+ *  token is appended into a TokenBuffer as (token-id of the rule, start,
+ *  end). Tokens of the skip rules are dropped. */
+template<typename LexerScope>
+class TokenBufferActionTable {
+ public:
+  TokenBufferActionTable() = default;
+  TokenBufferActionTable(const std::vector<Alphabet>* token_ids,
+                         const std::vector<uint8_t>* skip_tokens,
+                         TokenBuffer* token_buffer)
+  : token_ids(token_ids),
+    skip_tokens(skip_tokens),
+    token_buffer(token_buffer) {}
+
+  bool Invoke(int label, LexerScope* scope) const {
+    if ((*skip_tokens)[label]) {
+      return true;
+    }
+    auto& range = scope->__lexing_constructs.range;
+    return token_buffer->Append((*token_ids)[label], range.first,
+                                range.second);
+  }
+
+ private:
+  // not owned.
+  const std::vector<Alphabet>* token_ids = nullptr;
+  const std::vector<uint8_t>* skip_tokens = nullptr;
+  TokenBuffer* token_buffer = nullptr;
+};
+
+template<typename LexerScope = LexerScopeBase,
+         typename ActionTable = AnyActionTable<LexerScope>>
 class LexerInstance {
  public:
   LexerInstance() = default;
   LexerInstance(const Lexer& lexer, LexerScope* scope);
+  LexerInstance(const Lexer& lexer, LexerScope* scope,
+                const ActionTable& action_table);
 
   void Init(const Lexer& lexer, LexerScope* scope);
-
-  void FeedOrDie(const string& input) {
-    for (auto c : input) {
-      FeedOrDie(static_cast<unsigned char>(c));
+  void Init(const Lexer& lexer, LexerScope* scope,
+            const ActionTable& action_table);
+
+  /** Feed the bytes [data, data+len) in the LexerInstance. The rule actions
+   *  of the tokens completed within them are invoked in order. A token which
+   *  cannot be extended by any byte is completed as soon as its last byte is
+   *  fed, the others only once the next byte is fed (or at End).
+   *  @return false as soon as a byte cannot be consumed; the remaining bytes
+   *  are not fed. */
+  bool Feed(const char* data, size_t len) {
+    const auto& dfa = machine->dfa;
+    const int32_t* transition_table = dfa.transition_table.data();
+    const uint8_t* alphabet_class = dfa.alphabet_class.data();
+    const int32_t num_classes = dfa.num_alphabet_classes;
+    const int8_t* num_exit_bytes = dfa.num_exit_bytes.data();
+    const uint8_t* is_terminal_state = dfa.is_terminal_state.data();
+    const Offset base_offset = token_end;
+    auto& lexing_constructs = scope->__lexing_constructs;
+    token_rejected = false;
+    lexing_constructs.chunk = data;
+    lexing_constructs.chunk_offset = base_offset;
+    lexing_constructs.position_chunk = data;
+    lexing_constructs.position_chunk_offset = base_offset;
+    int32_t state = current_state;
+    for (size_t i = 0; i < len; i++) {
+      uint8_t c = static_cast<uint8_t>(data[i]);
+      int32_t next_state = transition_table[state * num_classes +
+                                            alphabet_class[c]];
+      if (next_state == LexerMachine::DFA::kDeadState) {
+        token_end = base_offset + i;
+        if (not dfa.IsFinal(state)) {
+          current_state = state;
+          EndChunk();
+          return false;
+        }
+        if (not EmitToken(state)) {
+          current_state = state;
+          EndChunk();
+          return false;
+        }
+        state = current_state;
+        next_state = transition_table[state * num_classes + alphabet_class[c]];
+        if (next_state == LexerMachine::DFA::kDeadState) {
+          EndChunk();
+          return false;
+        }
+      }
+      state = next_state;
+      if (num_exit_bytes[state] >= 0) {
+        i = dfa.SkipSelfLoop(state, data + i + 1, data + len) - data - 1;
+      } else if (is_terminal_state[state]) {
+        // No byte can extend the token, so don't wait for the next one.
+        token_end = base_offset + i + 1;
+        if (not EmitToken(state)) {
+          current_state = state;
+          EndChunk();
+          return false;
+        }
+        eager_token_end = token_end;
+        state = current_state;
+      }
     }
+    current_state = state;
+    token_end = base_offset + len;
+    EndChunk();
+    return true;
   }
 
-  bool Feed(const string& input) {
-    for (auto c : input) {
-      if (not Feed(static_cast<unsigned char>(c))) {
-        return false;
-      }
+  bool Feed(const char* data, size_t len, Error* error) {
+    if (not Feed(data, len)) {
+      *error = FailureError(Error::LEXER_ERROR_INVALID_TOKENS);
+      return false;
     }
     return true;
   }
 
-  bool Feed(const string& input, Error* error) {
-    for (auto c : input) {
-      if (not Feed(static_cast<unsigned char>(c), error)) {
+  void FeedOrDie(const char* data, size_t len) {
+    if (not Feed(data, len)) {
+      throw FailureError(Error::LEXER_ERROR_INVALID_TOKENS);
+    }
+  }
+
+  bool Feed(utils::string_view input) {
+    return Feed(input.data(), input.size());
+  }
+
+  bool Feed(utils::string_view input, Error* error) {
+    return Feed(input.data(), input.size(), error);
+  }
+
+  void FeedOrDie(utils::string_view input) {
+    FeedOrDie(input.data(), input.size());
+  }
+
+  /** Feed the whole input of @source, chunk by chunk. Tokens may straddle
+   *  the chunks. End() is not called.
+   *  In case of failure, the bytes of the current chunk that were not fed
+   *  are left in @source (refer to LexerInputSource::Unread), so lexing can
+   *  be resumed after a LEXER_ERROR_TOKEN_BUFFER_FULL. */
+  bool Feed(LexerInputSource* source, Error* error) {
+    while (true) {
+      auto chunk = source->Next();
+      if (chunk.empty()) break;
+      Offset chunk_offset = token_end;
+      if (not Feed(chunk, error)) {
+        source->Unread(chunk.size() - (token_end - chunk_offset));
         return false;
       }
     }
+    if (source->failed()) {
+      *error = Error(Error::LEXER_ERROR_INPUT_READ_FAILED)
+                    .Position(make_pair(token_end, token_end + 1))();
+      return false;
+    }
     return true;
   }
 
+  void FeedOrDie(LexerInputSource* source) {
+    Error error;
+    if (not Feed(source, &error)) {
+      throw error;
+    }
+  }
+
   void FeedOrDie(Alphabet a) {
     if (not Feed(a)) {
-      throw Error(Error::LEXER_ERROR_INVALID_TOKENS)
-                  .Position(make_pair(token_start, token_end+1))();
+      throw FailureError(Error::LEXER_ERROR_INVALID_TOKENS);
     }
   }
 
   bool Feed(Alphabet a, Error* error) {
     if (not Feed(a)) {
-      *error = Error(Error::LEXER_ERROR_INVALID_TOKENS)
-                      .Position(make_pair(token_start, token_end+1))();
+      *error = FailureError(Error::LEXER_ERROR_INVALID_TOKENS);
       return false;
     }
     return true;
   }
 
   bool Feed(Alphabet a) {
-    const auto* state = &machine->dfa.states[current_state];
-    if (not qk::ContainsKey(state->edges, a) &&
-        qk::ContainsKey(machine->dfa.final_states, current_state)) {
-      scope->__lexing_constructs.range = make_pair(token_start, token_end);
-      InvokeRuleAction(state->label);
-      current_state = section_to_start_state_mapping->at(
-                                      scope->__lexing_constructs.next_section);
-      state = &machine->dfa.states[current_state];
-      for (auto b : buffer) {
-        if (b == static_cast<unsigned char>('\n')) {
-          scope->__lexing_constructs.line_number++;
-          scope->__lexing_constructs.column_number = 0;
-        } else {
-          scope->__lexing_constructs.column_number++;
-        }
-      }
-      token_start = token_end;
-      buffer.clear();
-    }
-    if (qk::ContainsKey(state->edges, a)) {
-      current_state = state->edges.at(a);
-    } else {
+    if (static_cast<uint32_t>(a) >=
+        static_cast<uint32_t>(LexerMachine::DFA::kAlphabetSize)) {
+      token_rejected = false;
       return false;
     }
-    buffer.push_back(a);
-    token_end++;
-    return true;
+    char c = static_cast<char>(a);
+    return Feed(&c, 1);
   }
 
   void EndOrDie() {
     if (not End()) {
-      throw Error(Error::LEXER_ERROR_INCOMPLETE_TOKENS)
-                  .Position(make_pair(token_start, token_end+1))();
+      throw FailureError(Error::LEXER_ERROR_INCOMPLETE_TOKENS);
     }
   }
 
   bool End(Error* error) {
     if (not End()) {
-      *error = Error(Error::LEXER_ERROR_INCOMPLETE_TOKENS)
-                  .Position(make_pair(token_start, token_end+1))();
+      *error = FailureError(Error::LEXER_ERROR_INCOMPLETE_TOKENS);
       return false;
     }
     return true;
   }
 
   bool End() {
-    if (qk::ContainsKey(machine->dfa.final_states, current_state)) {
-      scope->__lexing_constructs.range = make_pair(token_start, token_end);
-      InvokeRuleAction(machine->dfa.states[current_state].label);
+    token_rejected = false;
+    if (token_end == eager_token_end) {
+      // The last token is emitted already.
       return true;
     }
+    if (machine->dfa.IsFinal(current_state)) {
+      return EmitToken(current_state);
+    }
     return false;
   }
 
   void Reset() {
     scope->__lexing_constructs.next_section = main_section;
-    current_state = machine->dfa.start_state;
+    current_state = section_start_states[main_section];
     token_start = 0;
     token_end = 0;
+    eager_token_end = -1;
+    carry.clear();
+    scope->__lexing_constructs.ResetPosition();
+  }
+
+  /** Reset, and then start the next token at the offset @offset of the
+   *  input, in the section with the index @section_index (in
+   *  `Lexer::sections`). The following Feed calls continue from @offset.
+   *  Line and column numbers are counted from @offset. */
+  void Restart(Offset offset, int section_index) {
+    Reset();
+    auto& lexing_constructs = scope->__lexing_constructs;
+    lexing_constructs.next_section = section_index;
+    lexing_constructs.synced_offset = offset;
+    lexing_constructs.chunk_offset = offset;
+    lexing_constructs.position_chunk_offset = offset;
+    lexing_constructs.position_chunk_end = offset;
+    lexing_constructs.position_token_start = offset;
+    current_state = section_start_states[section_index];
+    token_start = offset;
+    token_end = offset;
   }
 
  private:
-  void InvokeRuleAction(int label) {
-    using ActionType = std::function<void(LexerScope*)>;
-    auto& action = pattern_actions->at(label);
-    if (action.has_value()) {
-      if (action.can_cast_to<ActionType>()) {
-        action.cast_to<ActionType>()(scope);
-      } else {
-        throw Error(Error::INVALID_LEXER_RUN_ACTION_TYPE);
+  // Invoke the action of the token [token_start, token_end) recognised by the
+  // final state @state, and start the next token.
+  // Returns false, without starting the next token, if the action table
+  // rejected the token.
+  bool EmitToken(int32_t state) {
+    auto& lexing_constructs = scope->__lexing_constructs;
+    lexing_constructs.range = make_pair(token_start, token_end);
+    lexing_constructs.text = TokenText();
+    int label = machine->dfa.states[state].label;
+    if (label < keyword_tables->size() &&
+        not (*keyword_tables)[label].empty()) {
+      int keyword_label = (*keyword_tables)[label].Find(
+                              lexing_constructs.text.data(),
+                              lexing_constructs.text.size());
+      label = keyword_label > 0 ? keyword_label : label;
+    }
+    int next_section = lexing_constructs.next_section;
+    if (jump_to_sections[label] >= 0) {
+      lexing_constructs.next_section = jump_to_sections[label];
+    }
+    if (not action_table.Invoke(label, scope)) {
+      lexing_constructs.next_section = next_section;
+      token_rejected = true;
+      return false;
+    }
+    current_state = section_start_states[lexing_constructs.next_section];
+    token_start = token_end;
+    return true;
+  }
+
+  // Text of the token [token_start, token_end). It's in the chunk being fed,
+  // unless the token started in the previous chunks.
+  utils::string_view TokenText() {
+    auto& lexing_constructs = scope->__lexing_constructs;
+    if (token_start >= lexing_constructs.chunk_offset) {
+      if (lexing_constructs.chunk == nullptr) {
+        return utils::string_view();
       }
+      const char* chunk = lexing_constructs.chunk;
+      return utils::string_view(
+                 chunk + (token_start - lexing_constructs.chunk_offset),
+                 token_end - token_start);
     }
+    AppendToCarry();
+    return utils::string_view(carry.data(), carry.size());
+  }
+
+  // `carry` has the bytes [token_start, token_start + carry.size()). Append
+  // the rest of them, upto token_end, from the chunk being fed.
+  void AppendToCarry() {
+    auto& lexing_constructs = scope->__lexing_constructs;
+    Offset carry_end = token_start + carry.size();
+    if (lexing_constructs.chunk != nullptr && carry_end < token_end) {
+      const char* chunk = lexing_constructs.chunk;
+      carry.append(chunk + (carry_end - lexing_constructs.chunk_offset),
+                   token_end - carry_end);
+    }
+  }
+
+  // Called before returning from Feed. Since the chunk won't be available
+  // anymore, the bytes of the unfinished token in it are copied in `carry`.
+  void EndChunk() {
+    auto& lexing_constructs = scope->__lexing_constructs;
+    if (token_start >= lexing_constructs.chunk_offset) {
+      carry.clear();
+    }
+    AppendToCarry();
+    lexing_constructs.EndChunk(token_start, token_end);
+  }
+
+  // Error for the last failed Feed / End call.
+  Error FailureError(Error::ErrorStatus status) const {
+    if (token_rejected) {
+      status = Error::LEXER_ERROR_TOKEN_BUFFER_FULL;
+    }
+    return Error(status).Position(make_pair(token_start, token_end+1))();
   }
 
 
  public:
   const LexerMachine* machine;
-  const unordered_map<int, int>* section_to_start_state_mapping;
-  const unordered_map<int, utils::any>* pattern_actions;
-  int current_state, token_start = 0, token_end = 0;
-  std::vector<Alphabet> buffer;
+  // Refer to the same fields of Lexer. Not owned.
+  const int32_t* section_start_states;
+  const int32_t* jump_to_sections;
+  const std::vector<KeywordTable>* keyword_tables;
+  // Bytes of the unfinished token, which are not in the chunk being fed.
+  std::string carry;
+  ActionTable action_table;
+  int current_state;
+  Offset token_start = 0, token_end = 0;
+  // End of the last token emitted by a terminal state (refer to
+  // LexerMachine::DFA::is_terminal_state) in Feed, or -1.
+  Offset eager_token_end = -1;
+  // true iff the last Feed / End call failed because the action table
+  // rejected a token.
+  bool token_rejected = false;
+  // Index of the main section.
   int main_section;
   // not owned.
   LexerScope* scope;
@@ -181,6 +591,10 @@ class LexerInstance {
 
 class Lexer : public quick::AbstractType {
  public:
+  /** Section ids must be within a range of this size, since JumpTo maps
+   *  them to the sections by a flat array. */
+  static constexpr int64_t kMaxSectionIdRange = 1 << 20;
+
   string DebugString() const {
     return machine.DebugString();
   }
@@ -190,33 +604,136 @@ class Lexer : public quick::AbstractType {
     return LexerInstance<LexerScope>(*this, scope);
   }
 
+  /** LexerInstance in the token-buffer mode: rule actions are not invoked,
+   *  the tokens are appended into @token_buffer instead. */
+  template<typename LexerScope>
+  LexerInstance<LexerScope, TokenBufferActionTable<LexerScope>>
+  CreateInstance(LexerScope* scope, TokenBuffer* token_buffer) const {
+    using ActionTable = TokenBufferActionTable<LexerScope>;
+    return LexerInstance<LexerScope, ActionTable>(
+        *this, scope, ActionTable(&token_ids, &skip_tokens, token_buffer));
+  }
+
   bool Finalize();
   bool IsInitialized() const {
     return initialized;
   }
 
+  /** Start state of the section @section_id. */
+  int32_t StartState(int section_id) const {
+    return section_start_states.at(SectionIndex(section_id));
+  }
+
+  /** Index of the section @section_id in `sections`. */
+  int SectionIndex(int section_id) const {
+    auto it = std::lower_bound(sections.begin(), sections.end(), section_id);
+    APARSE_ASSERT(it != sections.end() && *it == section_id,
+                  "Invalid lexer section: " << section_id);
+    return it - sections.begin();
+  }
+
   LexerMachine machine;
-  unordered_map<int, int> section_to_start_state_mapping;
-  unordered_map<int, utils::any> pattern_actions;
+  /** Sections are numbered densely: sections[i] is the id of the i'th
+   *  section, in increasing order, and section_start_states[i] is its start
+   *  state in the DFA. */
+  std::vector<int> sections;
+  std::vector<int32_t> section_start_states;
+  /** Flat map(section id -> index) used by LexerScopeBase::JumpTo:
+   *  section_indexes[id - min_section_id] is the index of the section `id`,
+   *  or -1. Computed by Finalize. */
+  std::vector<int32_t> section_indexes;
+  int32_t min_section_id = 0;
+  /** Labels of the rules are 1, 2, ... The per-label fields below are
+   *  vectors indexed by label (label 0 is unused). */
+  std::vector<utils::any> actions;
+  /** Computed by Finalize. */
+  std::vector<uint8_t> has_action;
+  /** Pair(section id, index of the rule in that section). Used for
+   *  re-attaching the rule actions to an imported lexer. */
+  std::vector<pair<int, int>> label_to_rule;
+  /** token_ids[label] and skip_tokens[label] are the token-id and the skip
+   *  flag of the rule with the `label`. Used in the token-buffer mode. */
+  std::vector<Alphabet> token_ids;
+  std::vector<uint8_t> skip_tokens;
+  /** Index of the section switched to after the tokens of the rule
+   *  (refer to LexerGrammar::Rule::JumpTo), or -1. */
+  std::vector<int32_t> jump_to_sections;
+  /** keyword_tables[label] is the table of the keywords attached to the rule
+   *  with the `label` (refer to LexerGrammar::Rule::Keyword). Empty if none
+   *  of the rules has keywords. */
+  std::vector<KeywordTable> keyword_tables;
+  /** Id of the main section. */
   int main_section;
+  /** Computed by Finalize. */
+  int main_section_index;
   bool initialized = false;
 };
 
 
-template<typename LexerScope>
-LexerInstance<LexerScope>::LexerInstance(const Lexer& lexer,
-                                         LexerScope* scope) {
+/** Lexer whose rule actions are of the concrete type `Action`, fixed at
+ *  build time. Actions are stored in a dense vector indexed by label, so
+ *  invoking them needs neither a map lookup nor a runtime type check.
+ *  `Action` must be default constructible and callable as
+ *  `action(LexerScope*)`.
+ *  Built by LexerBuilder::Build(const TypedLexerGrammar&, TypedLexer*). */
+template<typename LexerScope, typename Action = void (*)(LexerScope*)>
+class TypedLexer {
+ public:
+  using ActionTable = DenseActionTable<LexerScope, Action>;
+  using Instance = LexerInstance<LexerScope, ActionTable>;
+
+  Instance CreateInstance(LexerScope* scope) const {
+    return Instance(lexer, scope, ActionTable(&actions));
+  }
+
+  bool IsInitialized() const {
+    return lexer.IsInitialized();
+  }
+
+  // `lexer.actions` are not used.
+  Lexer lexer;
+  // actions[label] = action of the rule with the `label`.
+  std::vector<Action> actions;
+};
+
+
+template<typename LexerScope, typename ActionTable>
+LexerInstance<LexerScope, ActionTable>::LexerInstance(const Lexer& lexer,
+                                                      LexerScope* scope) {
   this->Init(lexer, scope);
 }
 
-template<typename LexerScope>
-void LexerInstance<LexerScope>::Init(const Lexer& lexer, LexerScope* scope) {
+template<typename LexerScope, typename ActionTable>
+LexerInstance<LexerScope, ActionTable>::LexerInstance(
+    const Lexer& lexer,
+    LexerScope* scope,
+    const ActionTable& action_table) {
+  this->Init(lexer, scope, action_table);
+}
+
+template<typename LexerScope, typename ActionTable>
+void LexerInstance<LexerScope, ActionTable>::Init(const Lexer& lexer,
+                                                  LexerScope* scope) {
+  this->Init(lexer, scope, ActionTable(&lexer.actions, &lexer.has_action));
+}
+
+template<typename LexerScope, typename ActionTable>
+void LexerInstance<LexerScope, ActionTable>::Init(
+    const Lexer& lexer,
+    LexerScope* scope,
+    const ActionTable& action_table) {
   APARSE_ASSERT(lexer.IsInitialized());
   this->scope = scope;
   this->machine = &lexer.machine;
-  this->section_to_start_state_mapping = &lexer.section_to_start_state_mapping;
-  this->pattern_actions = &lexer.pattern_actions;
-  this->main_section = lexer.main_section;
+  this->section_start_states = lexer.section_start_states.data();
+  this->jump_to_sections = lexer.jump_to_sections.data();
+  this->keyword_tables = &lexer.keyword_tables;
+  this->action_table = action_table;
+  this->main_section = lexer.main_section_index;
+  auto& lexing_constructs = scope->__lexing_constructs;
+  lexing_constructs.section_indexes = lexer.section_indexes.data();
+  lexing_constructs.min_section_id = lexer.min_section_id;
+  lexing_constructs.num_section_ids = lexer.section_indexes.size();
   this->Reset();
 }
 
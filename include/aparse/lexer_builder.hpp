@@ -4,6 +4,7 @@
 #ifndef APARSE_LEXER_BUILDER_HPP_
 #define APARSE_LEXER_BUILDER_HPP_
 
+#include <algorithm>
 #include <tuple>
 #include <string>
 #include <vector>
@@ -33,17 +34,138 @@ class LexerGrammar {
       this->action = quick::function_type<T>(action);
       return *this;
     }
+    /** Token-id of the tokens of this rule, in the token-buffer mode. */
+    Rule& Token(Alphabet token_id) {
+      this->token_id = token_id;
+      return *this;
+    }
+    /** Tokens of this rule (eg: whitespaces, comments) are dropped in the
+     *  token-buffer mode. */
+    Rule& Skip() {
+      this->skip = true;
+      return *this;
+    }
+    /** Switch to the @section after the tokens of this rule. It's same as
+     *  calling `scope->JumpTo(section)` from the action, except that it
+     *  works in the token-buffer mode as well. The action, if any, is
+     *  invoked after the switch, so it can still override it. */
+    Rule& JumpTo(int section) {
+      this->has_jump_to = true;
+      this->jump_to = section;
+      return *this;
+    }
+    /** Attach a keyword to this (identifier) rule. The `regex_string` of
+     *  @keyword is the literal keyword, its action, token-id and skip flag
+     *  are used when the lexeme of this rule is exactly the keyword.
+     *  Keywords are not expanded into the lexer DFA; the lexemes of this rule
+     *  are looked up in a perfect hash table of its keywords instead. So a
+     *  keyword must itself be a lexeme of this rule. */
+    Rule& Keyword(const Rule& keyword) {
+      keywords.push_back(keyword);
+      return *this;
+    }
     string regex_string;
     utils::any action;
+    Alphabet token_id = 0;
+    bool skip = false;
+    bool has_jump_to = false;
+    int jump_to = 0;
+    vector<Rule> keywords;
   };
   unordered_map<int, vector<Rule>> rules;
   int main_section = 0;
   bool Finalize();
 };
 
+/** Same as LexerGrammar, with the rule actions of the concrete type `Action`.
+ *  Used for building TypedLexer. */
+template<typename LexerScope, typename Action = void (*)(LexerScope*)>
+class TypedLexerGrammar {
+ public:
+  struct Rule {
+    Rule(const string& regex_string, const Action& action)
+    : regex_string(regex_string), action(action) {}
+    string regex_string;
+    Action action;
+  };
+
+  /** Same grammar without the actions. */
+  LexerGrammar ToLexerGrammar() const {
+    LexerGrammar output;
+    for (auto& section : rules) {
+      for (auto& rule : section.second) {
+        output.rules[section.first].emplace_back(rule.regex_string);
+      }
+    }
+    output.main_section = main_section;
+    return output;
+  }
+
+  unordered_map<int, vector<Rule>> rules;
+  int main_section = 0;
+};
+
 class LexerBuilder {
  public:
   static bool Build(const LexerGrammar& lexer_grammar, Lexer* lexer);
+
+  /** Same as ParserBuilder::Import, for Lexer. The lexer's machine is
+   *  imported from the string and only the rule actions are taken from
+   *  @lexer_grammar.
+   *  Import(..) fails if the checksum of the rule strings of @lexer_grammar is
+   *  different from the one of the exported grammar. */
+  static bool Import(const std::string& serialized_lexer,
+                     const LexerGrammar& lexer_grammar,
+                     Lexer* lexer);
+
+  /** Export the Lexer object into a string, which can be stored in a file. */
+  static void Export(const Lexer& lexer,
+                     const LexerGrammar& lexer_grammar,
+                     std::string* serialized_lexer);
+
+  /** Same as above Export method.
+   * @returns serialized_lexer. */
+  static std::string Export(const Lexer& lexer,
+                            const LexerGrammar& lexer_grammar);
+
+  /** Build the TypedLexer for @lexer_grammar. */
+  template<typename LexerScope, typename Action>
+  static bool Build(const TypedLexerGrammar<LexerScope, Action>& lexer_grammar,
+                    TypedLexer<LexerScope, Action>* lexer) {
+    if (not Build(lexer_grammar.ToLexerGrammar(), &lexer->lexer)) {
+      return false;
+    }
+    AttachActions(lexer_grammar, lexer);
+    return true;
+  }
+
+  /** Import the TypedLexer exported as:
+   *  Export(lexer.lexer, lexer_grammar.ToLexerGrammar()). */
+  template<typename LexerScope, typename Action>
+  static bool Import(const std::string& serialized_lexer,
+                     const TypedLexerGrammar<LexerScope, Action>& lexer_grammar,
+                     TypedLexer<LexerScope, Action>* lexer) {
+    if (not Import(serialized_lexer, lexer_grammar.ToLexerGrammar(),
+                   &lexer->lexer)) {
+      return false;
+    }
+    AttachActions(lexer_grammar, lexer);
+    return true;
+  }
+
+ private:
+  template<typename LexerScope, typename Action>
+  static void AttachActions(
+      const TypedLexerGrammar<LexerScope, Action>& lexer_grammar,
+      TypedLexer<LexerScope, Action>* lexer) {
+    auto& label_to_rule = lexer->lexer.label_to_rule;
+    lexer->actions.assign(label_to_rule.size(), Action());
+    for (int label = 1; label < label_to_rule.size(); label++) {
+      auto& rule = label_to_rule[label];
+      lexer->actions[label] = lexer_grammar.rules.at(rule.first)
+                                                 .at(rule.second).action;
+    }
+  }
 };
 
 }  // namespace aparse
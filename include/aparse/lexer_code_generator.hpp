@@ -0,0 +1,45 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#ifndef APARSE_LEXER_CODE_GENERATOR_HPP_
+#define APARSE_LEXER_CODE_GENERATOR_HPP_
+
+#include <string>
+
+#include "aparse/lexer.hpp"
+#include "aparse/lexer_builder.hpp"
+
+namespace aparse {
+
+/** Generates standalone C++ source (a header, depending only on the standard
+ *  library) for a lexer, so that it can be compiled into the binaries with
+ *  zero construction time at startup.
+ *  The lexer DFA is encoded as `static constexpr` members of the class
+ *  template `LexerTables`, so that the header can be included in several
+ *  translation units, along with the entry point:
+ *
+ *    namespace <namespace_name> {
+ *    template<typename Sink>
+ *    bool Lex(const char* data, size_t len, Sink& sink);
+ *    }
+ *
+ *  It works as the token-buffer mode of the LexerInstance: rule actions are
+ *  not used, `sink(token_id, start, end)` is called for every token, except
+ *  for the tokens of the skip rules. Lexing is done in the main section.
+ *  Lex(..) returns false in case of invalid or incomplete tokens.
+ *  Keywords (LexerGrammar::Rule::Keyword) and JumpTo to the other sections
+ *  are not supported yet.
+ *  Refer to `tools/cpp_tools/generate_lexer_cpp.cpp` for the command line
+ *  tool. */
+class LexerCodeGenerator {
+ public:
+  static std::string Generate(const Lexer& lexer,
+                              const std::string& namespace_name);
+
+  static std::string Generate(const LexerGrammar& lexer_grammar,
+                              const std::string& namespace_name);
+};
+
+}  // namespace aparse
+
+#endif  // APARSE_LEXER_CODE_GENERATOR_HPP_
@@ -0,0 +1,120 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#ifndef APARSE_LEXER_INPUT_HPP_
+#define APARSE_LEXER_INPUT_HPP_
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "aparse/utils/string_view.hpp"
+
+namespace aparse {
+
+/** Source of the lexer input, read chunk by chunk. Used by
+ *  LexerInstance::Feed(LexerInputSource*), so that a large input doesn't
+ *  have to be loaded in memory as a whole.
+ *  A chunk is valid until the next call of `Next`. */
+class LexerInputSource {
+ public:
+  virtual ~LexerInputSource() = default;
+
+  /** Next chunk of the input. Empty at the end of the input, or if reading
+   *  it failed (refer to `failed()`). */
+  utils::string_view Next() {
+    if (not unread.empty()) {
+      current = unread;
+      unread = utils::string_view();
+    } else {
+      current = ReadChunk();
+    }
+    return current;
+  }
+
+  /** The next call of `Next` returns the last @n bytes of the current chunk
+   *  again, instead of reading the next chunk. */
+  void Unread(size_t n) {
+    unread = current.substr(current.size() - n, n);
+  }
+
+  bool failed() const {
+    return failed_;
+  }
+
+ protected:
+  /** Read the next chunk. The previous one can be released. */
+  virtual utils::string_view ReadChunk() = 0;
+
+  bool failed_ = false;
+
+ private:
+  utils::string_view current, unread;
+};
+
+/** Memory mapped file. The chunks point into the mapping, so the input is not
+ *  copied. The file is mapped `window_size` bytes at a time, each window is
+ *  unmapped once the lexer moves to the next one, so that the resident
+ *  memory stays bounded for the files of any size. */
+class MmapInputSource : public LexerInputSource {
+ public:
+  explicit MmapInputSource(size_t window_size = kDefaultWindowSize);
+  ~MmapInputSource() override;
+  MmapInputSource(const MmapInputSource&) = delete;
+  MmapInputSource& operator=(const MmapInputSource&) = delete;
+
+  /** @returns false if the file cannot be opened. */
+  bool Open(const std::string& path);
+
+  static constexpr size_t kDefaultWindowSize = 64 << 20;
+
+ protected:
+  utils::string_view ReadChunk() override;
+
+ private:
+  void Unmap();
+
+  size_t window_size;
+  int fd = -1;
+  size_t file_size = 0, offset = 0;
+  void* window = nullptr;
+  size_t window_length = 0;
+};
+
+/** Reads from a file descriptor into a reusable chunk buffer. The file
+ *  descriptor is not owned. */
+class FdInputSource : public LexerInputSource {
+ public:
+  explicit FdInputSource(int fd, size_t chunk_size = kDefaultChunkSize);
+
+  static constexpr size_t kDefaultChunkSize = 1 << 16;
+
+ protected:
+  utils::string_view ReadChunk() override;
+
+ private:
+  int fd;
+  std::vector<char> buffer;
+};
+
+/** Reads from a std::istream into a reusable chunk buffer. The stream is not
+ *  owned. */
+class IstreamInputSource : public LexerInputSource {
+ public:
+  explicit IstreamInputSource(std::istream* input,
+                              size_t chunk_size = kDefaultChunkSize);
+
+  static constexpr size_t kDefaultChunkSize = 1 << 16;
+
+ protected:
+  utils::string_view ReadChunk() override;
+
+ private:
+  std::istream* input;
+  std::vector<char> buffer;
+};
+
+}  // namespace aparse
+
+#endif  // APARSE_LEXER_INPUT_HPP_
@@ -8,6 +8,10 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <string>
+#include <utility>
+#include <cstdint>
+
+#include "quick/byte_stream.hpp"
 
 #include "aparse/utils/very_common_headers.hpp"
 
@@ -19,7 +23,7 @@ struct LexerMachine {
   struct NFA {
     struct NFAState {
       std::unordered_map<Alphabet, std::unordered_set<int>> edges;
-      int label;  // optional field for external identification purpose.
+      int label = 0;  // optional field for external identification purpose.
     };
     std::vector<NFAState> states;
     int start_state;
@@ -28,17 +32,111 @@ struct LexerMachine {
   };
 
   struct DFA {
+    /** Target of a missing edge in `transition_table`. */
+    static constexpr int32_t kDeadState = -1;
+    /** Alphabets of a lexer DFA are bytes, i.e. {0, 1, ... 255}. */
+    static constexpr int32_t kAlphabetSize = 256;
+    /** Maximum number of exit bytes of an accelerable state. */
+    static constexpr int32_t kMaxExitBytes = 3;
+
     struct DFAState {
       std::unordered_map<Alphabet, int> edges;
-      int label;  // optional field for external identification purpose.
+      int label = 0;  // optional field for external identification purpose.
+      void Serialize(quick::OByteStream& bs) const {  // NOLINT
+        bs << edges << label;
+      }
+      void Deserialize(quick::IByteStream& bs) {  // NOLINT
+        bs >> edges >> label;
+      }
     };
+
+    /** Next state of @state on alphabet @a, using the compiled
+     *  `transition_table`. Returns kDeadState if there is no such edge. */
+    inline int32_t Next(int32_t state, Alphabet a) const {
+      if (static_cast<uint32_t>(a) >= static_cast<uint32_t>(kAlphabetSize)) {
+        return kDeadState;
+      }
+      return transition_table[state * num_alphabet_classes +
+                              alphabet_class[a]];
+    }
+    inline bool IsFinal(int32_t state) const {
+      return is_final_state[state];
+    }
+    inline bool IsTerminal(int32_t state) const {
+      return is_terminal_state[state];
+    }
+    inline bool IsAccelerable(int32_t state) const {
+      return num_exit_bytes[state] >= 0;
+    }
+
+    /** Returns the first byte in [begin, end) on which the accelerable
+     *  @state doesn't loop on itself, or @end if there is no such byte.
+     *  Scans 16 bytes at a time where SSE2 is available. */
+    const char* SkipSelfLoop(int32_t state,
+                             const char* begin,
+                             const char* end) const;
+
     std::vector<DFAState> states;
     int start_state;
     std::unordered_set<int> final_states;
+    /** Compiled form of `states` and `final_states`, used on the lexing hot
+     *  path. Built by LexerMachineBuilder::CompileDFA once all the DFAs are
+     *  merged.
+     *  Bytes are grouped into equivalence classes: two bytes are in the same
+     *  class iff every state has the same target on both of them.
+     *  alphabet_class[a] is the class of the byte `a`. Classes are numbered
+     *  {0, 1, ... num_alphabet_classes-1}. */
+    std::vector<uint8_t> alphabet_class;
+    int32_t num_alphabet_classes = 0;
+    /** Dense `states x num_alphabet_classes` table, s.t.
+     *  transition_table[s * num_alphabet_classes + c] is the target of the
+     *  state `s` on the bytes of class `c`, or kDeadState if `s` has no edge
+     *  on them. */
+    std::vector<int32_t> transition_table;
+    /** is_final_state[s] = 1 iff `s` is in `final_states`. */
+    std::vector<uint8_t> is_final_state;
+    /** is_terminal_state[s] = 1 iff `s` is a final state without any outgoing
+     *  edge. The token recognised by such a state cannot be extended, so the
+     *  lexer emits it right away, without waiting for the next byte. */
+    std::vector<uint8_t> is_terminal_state;
+    /** A state is accelerable if it loops on itself on all the bytes except
+     *  at most kMaxExitBytes of them (eg: the body of a comment or of a
+     *  string literal). The lexer skips through such a state by scanning for
+     *  its exit bytes, instead of stepping one byte at a time.
+     *  num_exit_bytes[s] = number of exit bytes of the state `s`, or -1 if
+     *  `s` is not accelerable. Its exit bytes are
+     *  exit_bytes[s * kMaxExitBytes + i] for i < num_exit_bytes[s]. */
+    std::vector<int8_t> num_exit_bytes;
+    std::vector<uint8_t> exit_bytes;
     std::string DebugString() const;
+    void Serialize(quick::OByteStream& bs) const {  // NOLINT
+      bs << states << start_state << final_states << alphabet_class
+         << num_alphabet_classes << transition_table << is_final_state
+         << is_terminal_state << num_exit_bytes << exit_bytes;
+    }
+    void Deserialize(quick::IByteStream& bs) {  // NOLINT
+      bs >> states >> start_state >> final_states >> alphabet_class
+         >> num_alphabet_classes >> transition_table >> is_final_state
+         >> is_terminal_state >> num_exit_bytes >> exit_bytes;
+    }
+  };
+  /** Statistics collected by LexerMachineBuilder while building this
+   *  machine. These are only for reporting, lexing never reads them. */
+  struct BuildStats {
+    /** Map(section -> Pair(1. Number of DFA states after subset construction,
+     *                      2. Number of DFA states after minimization)) */
+    std::unordered_map<int, std::pair<int, int>> section_dfa_sizes;
+    /** Map(section -> Working memory (in bytes) of its subset construction) */
+    std::unordered_map<int, size_t> section_peak_memory;
+    /** Upper bound of the peak working memory of the builder, in bytes. It's
+     *  the sum over the sections, as they may be built concurrently. */
+    size_t peak_memory = 0;
+    /** Wall time of the whole lexer build, in microseconds. */
+    int64_t build_time_us = 0;
   };
   DFA dfa;
   std::unordered_map<int, int> section_index;
+  BuildStats build_stats;
   bool initialized = false;
   std::string DebugString() const {
     return dfa.DebugString();
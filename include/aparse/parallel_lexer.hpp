@@ -0,0 +1,72 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#ifndef APARSE_PARALLEL_LEXER_HPP_
+#define APARSE_PARALLEL_LEXER_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "aparse/error.hpp"
+#include "aparse/lexer.hpp"
+
+namespace aparse {
+
+/** Lexes a large input on multiple threads, in the token-buffer mode (refer
+ *  to Lexer::CreateInstance(scope, token_buffer)). The output token stream,
+ *  including the token ranges, is identical to the one of the sequential
+ *  lexing.
+ *  The input is split in `num_threads` chunks. Each chunk is lexed on its own
+ *  thread, speculating that a token starts at the beginning of the chunk.
+ *  Then the chunks are stitched in order: the true token boundaries are
+ *  lexed sequentially from the end of the previous chunk, until one of them
+ *  coincides with a speculated token boundary. The rest of the speculated
+ *  tokens of the chunk are valid from there onwards, since the lexer DFA is
+ *  deterministic.
+ *  The chunks are lexed on a pool of `num_threads - 1` threads owned by the
+ *  ParallelLexer, and on the calling thread. Lex can be called concurrently.
+ *  Rule actions are not invoked in the token-buffer mode, hence there is no
+ *  JumpTo; the whole input is lexed in the main section. Lexers having rules
+ *  with JumpTo (LexerGrammar::Rule::JumpTo) to the other sections are not
+ *  supported: Lex fails with LEXER_ERROR_UNSUPPORTED_SECTIONS. */
+class ParallelLexer {
+ public:
+  ParallelLexer(const Lexer& lexer, int num_threads);
+  ~ParallelLexer();
+  ParallelLexer(const ParallelLexer&) = delete;
+  ParallelLexer& operator=(const ParallelLexer&) = delete;
+
+  /** Lex [data, data+len) and append the tokens into @output.
+   *  @returns false in case of invalid or incomplete tokens, if @output
+   *  gets full, or if the lexer uses sections. */
+  bool Lex(const char* data, size_t len, TokenBuffer* output,
+           Error* error) const;
+
+  void LexOrDie(const char* data, size_t len, TokenBuffer* output) const;
+
+ private:
+  /** Run @tasks on the thread pool, and wait for all of them. */
+  void RunOnPool(std::vector<std::function<void()>>* tasks) const;
+  void Worker();
+
+  // not owned.
+  const Lexer* lexer;
+  int num_threads;
+  // true if any rule jumps to a section other than the main one.
+  bool uses_sections = false;
+  std::vector<std::thread> workers;
+  mutable std::mutex mutex;
+  mutable std::condition_variable task_available;
+  // Guarded by `mutex`.
+  mutable std::deque<std::function<void()>> pending_tasks;
+  bool stopped = false;
+};
+
+}  // namespace aparse
+
+#endif  // APARSE_PARALLEL_LEXER_HPP_
@@ -214,10 +214,16 @@ class Parser {
    *  different parsing mechanisms. A mechanisms might need their own
    *  representation of AParseMachine object. AParseMachine type must be
    *  derived from `quick::AbstractType` type.
-   *  The `@machine_type` field controls the choice of AParseMachine.
-   *  `src/v2/AParseMachine.hpp` is the AParseMachine used currently. */
+   *  The `@machine_type` field controls the choice of AParseMachine:
+   *  `src/v2/aparse_machine.hpp` for VERY_HIGH_COMPRESSION and
+   *  `src/v2/deterministic_aparse_machine.hpp` for VERY_LOW_COMPRESSION. */
   std::unique_ptr<quick::AbstractType> machine;
 
+  /** Cache of the transitions of `machine`, shared by all the
+   *  ParserInstances. Used by the VERY_HIGH_COMPRESSION machine type only.
+   *  Learn more at `src/v2/transition_cache.hpp`. */
+  std::unique_ptr<quick::AbstractType> transition_cache;
+
   /** @syntax_tree_maker is used for constructing SyntaxTree from a ParseTree.
    *  Learn more at `include/aparse/syntax_tree_maker.hpp`. */
   std::unique_ptr<SyntaxTreeMaker> syntax_tree_maker;
@@ -70,6 +70,14 @@ class ParserBuilder {
 
   /** Given a ParserGrammar, built the Parser object */
   static void Build(const ParserGrammar& parser_grammar, Parser* parser);
+
+  /** Same as above Build method, with the choice of @machine_type.
+   *  Parser::VERY_LOW_COMPRESSION builds a deterministic AParseMachine, which
+   *  takes longer to build and is larger, but feeding an alphabet is a single
+   *  table lookup. The machine type is kept in the exported Parser. */
+  static void Build(const ParserGrammar& parser_grammar,
+                    Parser::AParseMachineType machine_type,
+                    Parser* parser);
 };
 
 }  // namespace aparse
@@ -34,12 +34,12 @@ class ParserScopeBase {
     unordered_map<int, vector<int>> child_st_list_1;
     unordered_map<int, vector<SyntaxTreeNode>> child_st_list_1_tmp;
     vector<SyntaxTreeNode> child_st_list_2;
-    unordered_map<int, vector<pair<int, int>>> range_list_1;
-    unordered_map<int, vector<int>> token_stream_index_map;
-    vector<int> token_stream_index_map_2;
-    vector<pair<int, int>> range_list_2;
+    unordered_map<int, vector<pair<Offset, Offset>>> range_list_1;
+    unordered_map<int, vector<Offset>> token_stream_index_map;
+    vector<Offset> token_stream_index_map_2;
+    vector<pair<Offset, Offset>> range_list_2;
     unordered_map<int, bool> is_terminal;
-    pair<int, int> range;
+    pair<Offset, Offset> range;
     void Clear() {
       child_st_list_2.clear();
       child_st_list_1.clear();
@@ -57,18 +57,18 @@ class ParserScopeBase {
   Alphabet GetAlphabet() {
     return tree_building_constructs->token_list_2.at(0);
   }
-  vector<int> AlphabetIndexList(int index) {
+  vector<Offset> AlphabetIndexList(int index) {
     auto& tbc = *tree_building_constructs;
     return tbc.token_stream_index_map[tbc.rule_atoms_->at(index)];
   }
-  int AlphabetIndex(int index) {
+  Offset AlphabetIndex(int index) {
     return AlphabetIndexList(index)[0];
   }
-  vector<int> AlphabetIndexList() {
+  vector<Offset> AlphabetIndexList() {
     auto& tbc = *tree_building_constructs;
     return tbc.token_stream_index_map_2;
   }
-  int AlphabetIndex() {
+  Offset AlphabetIndex() {
     return AlphabetIndexList()[0];
   }
   vector<Alphabet>& GetAlphabetList() {
@@ -106,7 +106,7 @@ class ParserScopeBase {
     return qk::ContainsKey(tbc.token_list_1, term_id) ||
             qk::ContainsKey(tbc.child_st_list_1, term_id);
   }
-  pair<int, int> Range() {
+  pair<Offset, Offset> Range() {
     return tree_building_constructs->range;
   }
   TreeBuildingConstructs* MutableTreeBuildingConstructs() {
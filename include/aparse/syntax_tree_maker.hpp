@@ -46,7 +46,8 @@ struct SyntaxTreeMaker {
     lCreateST = [&](const CoreParseNode& node, SyntaxTreeNode* output) {
       vector<SyntaxTreeNode> child_st_list;
       child_st_list.resize(node.children.size());
-      for (int s = node.start, c_index = 0; s < node.end;) {
+      int c_index = 0;
+      for (Offset s = node.start; s < node.end;) {
         if (c_index < node.children.size() &&
              s == node.children[c_index].start) {
           lCreateST(node.children[c_index], &child_st_list[c_index]);
@@ -58,7 +59,8 @@ struct SyntaxTreeMaker {
       }
       tbc.Clear();
       tbc.child_st_list_2 = std::move(child_st_list);
-      for (int s = node.start, c_index = 0; s < node.end;) {
+      c_index = 0;
+      for (Offset s = node.start; s < node.end;) {
         if (c_index < node.children.size() &&
              s == node.children[c_index].start) {
           auto& child = node.children[c_index];
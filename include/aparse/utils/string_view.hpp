@@ -0,0 +1,58 @@
+// Copyright: 2020 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+// This is a naive implementation of std::string_view (not available in
+// C++14). Only the subset used by aparse is implemented.
+
+#ifndef APARSE_SRC_UTILS_STRING_VIEW_HPP_
+#define APARSE_SRC_UTILS_STRING_VIEW_HPP_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace aparse {
+namespace utils {
+
+class string_view {
+ public:
+  constexpr string_view() = default;
+  constexpr string_view(const char* data, size_t size)
+  : data_(data), size_(size) {}
+  string_view(const char* data)  // NOLINT
+  : data_(data), size_(std::strlen(data)) {}
+  string_view(const std::string& input)  // NOLINT
+  : data_(input.data()), size_(input.size()) {}
+
+  constexpr const char* data() const { return data_; }
+  constexpr size_t size() const { return size_; }
+  constexpr bool empty() const { return size_ == 0; }
+  constexpr const char* begin() const { return data_; }
+  constexpr const char* end() const { return data_ + size_; }
+  constexpr char operator[](size_t i) const { return data_[i]; }
+
+  constexpr string_view substr(size_t pos, size_t count) const {
+    return string_view(data_ + pos, count < size_ - pos ? count : size_ - pos);
+  }
+
+  std::string to_string() const {
+    return std::string(data_, size_);
+  }
+
+  bool operator==(const string_view& other) const {
+    return size_ == other.size_ &&
+           (size_ == 0 || std::memcmp(data_, other.data_, size_) == 0);
+  }
+  bool operator!=(const string_view& other) const {
+    return not (*this == other);
+  }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace utils
+}  // namespace aparse
+
+#endif  // APARSE_SRC_UTILS_STRING_VIEW_HPP_
@@ -6,6 +6,8 @@
 #ifndef APARSE_UTILS_VERY_COMMON_HEADERS_HPP_
 #define APARSE_UTILS_VERY_COMMON_HEADERS_HPP_
 
+#include <cstdint>
+
 namespace aparse {
 
 /** Alphabets of a grammar are {0, 1, 2, ... alphabet_size-1} */
@@ -17,6 +19,19 @@ using Alphabet = int32_t;
  *  section defining AParseGrammar */
 using EnclosedNonTerminal = int32_t;
 
+/** Offset of a byte in the input of the lexer, or of an alphabet in the input
+ *  of the parser. Token ranges, parse-tree ranges and error positions are
+ *  made of offsets.
+ *  It's 32 bit by default, for the compact token buffers and parse trees.
+ *  Define APARSE_64BIT_OFFSETS for the inputs larger than 2GB; it must be
+ *  defined the same way for src/aparse.cpp and all of its clients.
+ *  `scons offsets64=1` builds with it defined, into build-<mode>-offsets64. */
+#ifdef APARSE_64BIT_OFFSETS
+using Offset = int64_t;
+#else
+using Offset = int32_t;
+#endif
+
 }  // namespace aparse
 
 #ifndef APARSE_DEBUG_FLAG
@@ -8,16 +8,23 @@
 // Generated using:
 // for i in $(ls src/*.cpp | cat | grep -v '_test'); do echo "#include \"$i\"" ; done #  NOLINT
 
+#include "src/batch_lexer.cpp"  // NOLINT
 #include "src/core_parse_node.cpp"  // NOLINT
+#include "src/incremental_lexer.cpp"  // NOLINT
+#include "src/keyword_table.cpp"  // NOLINT
 #include "src/lexer.cpp"  // NOLINT
+#include "src/lexer_input.cpp"  // NOLINT
 #include "src/internal_lexer_builder.cpp"  // NOLINT
 #include "src/lexer_builder.cpp"  // NOLINT
+#include "src/lexer_code_generator.cpp"  // NOLINT
 #include "src/aparse_grammar.cpp"  // NOLINT
 #include "src/error.cpp"  // NOLINT
 #include "src/helpers.cpp"  // NOLINT
 #include "src/internal_parser_builder.cpp"  // NOLINT
+#include "src/lexer_machine.cpp"  // NOLINT
 #include "src/lexer_machine_builder.cpp"  // NOLINT
 #include "src/parse_char_regex.cpp"  // NOLINT
+#include "src/parallel_lexer.cpp"  // NOLINT
 #include "src/parse_char_regex_rules.cpp"  // NOLINT
 #include "src/parser_builder.cpp"  // NOLINT
 #include "src/parser.cpp"  // NOLINT
@@ -30,4 +37,7 @@
 #include "src/v2/aparse_machine_builder.cpp"  // NOLINT
 #include "src/v2/aparse_machine.cpp"  // NOLINT
 #include "src/v2/core_parser.cpp"  // NOLINT
+#include "src/v2/deterministic_aparse_machine.cpp"  // NOLINT
+#include "src/v2/deterministic_core_parser.cpp"  // NOLINT
 #include "src/v2/internal_aparse_grammar.cpp"  // NOLINT
+#include "src/v2/transition_cache.cpp"  // NOLINT
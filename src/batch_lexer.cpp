@@ -0,0 +1,139 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/batch_lexer.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace aparse {
+
+namespace {
+
+// Cursor of a lane over its current input.
+struct Lane {
+  int input;
+  const char* data;
+  Offset len;
+  Offset i;
+  Offset token_start;
+  int32_t state;
+};
+
+}  // namespace
+
+constexpr int BatchLexer::kNumLanes;
+
+BatchLexer::BatchLexer(const Lexer& lexer) : lexer(&lexer) {
+  APARSE_ASSERT(lexer.IsInitialized());
+  for (int32_t section : lexer.jump_to_sections) {
+    if (section >= 0 && section != lexer.main_section_index) {
+      uses_sections = true;
+    }
+  }
+}
+
+bool BatchLexer::LexBatch(const std::vector<utils::string_view>& inputs,
+                          std::vector<TokenBuffer>* outputs,
+                          std::vector<Error>* errors) const {
+  APARSE_ASSERT(outputs->size() == inputs.size());
+  if (uses_sections) {
+    errors->assign(inputs.size(),
+                   Error(Error::LEXER_ERROR_UNSUPPORTED_SECTIONS));
+    return inputs.empty();
+  }
+  errors->assign(inputs.size(), Error());
+  const auto& dfa = lexer->machine.dfa;
+  const int32_t* transition_table = dfa.transition_table.data();
+  const uint8_t* alphabet_class = dfa.alphabet_class.data();
+  const int32_t num_classes = dfa.num_alphabet_classes;
+  const int32_t start_state = lexer->section_start_states[
+                                                  lexer->main_section_index];
+  const auto& keyword_tables = lexer->keyword_tables;
+  bool success = true;
+  auto lFail = [&](const Lane& lane, Error::ErrorStatus status,
+                   Offset end) {
+    (*errors)[lane.input] = Error(status).Position(
+                                make_pair(lane.token_start, end + 1))();
+    success = false;
+    return false;
+  };
+  // Append the token [token_start, i) recognised by the final state of the
+  // lane.
+  auto lAppend = [&](const Lane& lane) {
+    int label = dfa.states[lane.state].label;
+    if (label < keyword_tables.size() && not keyword_tables[label].empty()) {
+      int keyword_label = keyword_tables[label].Find(
+                              lane.data + lane.token_start,
+                              lane.i - lane.token_start);
+      label = keyword_label > 0 ? keyword_label : label;
+    }
+    if (lexer->skip_tokens[label]) {
+      return true;
+    }
+    return (*outputs)[lane.input].Append(lexer->token_ids[label],
+                                         lane.token_start, lane.i);
+  };
+  // Called when the lane cannot consume its next byte, or reached the end of
+  // its input. Emits the token ending there and starts the next one.
+  // Returns false once the lane is done with its input.
+  auto lEndToken = [&](Lane* lane) {
+    if (not dfa.IsFinal(lane->state)) {
+      return lFail(*lane, (lane->i == lane->len
+                              ? Error::LEXER_ERROR_INCOMPLETE_TOKENS
+                              : Error::LEXER_ERROR_INVALID_TOKENS), lane->i);
+    }
+    if (not lAppend(*lane)) {
+      return lFail(*lane, Error::LEXER_ERROR_TOKEN_BUFFER_FULL, lane->i);
+    }
+    if (lane->i == lane->len) {
+      return false;
+    }
+    if (lane->i == lane->token_start) {
+      // Empty token: the next byte cannot be consumed from the start state.
+      return lFail(*lane, Error::LEXER_ERROR_INVALID_TOKENS, lane->i);
+    }
+    lane->token_start = lane->i;
+    lane->state = start_state;
+    return true;
+  };
+  Lane lanes[kNumLanes];
+  int num_lanes = 0;
+  size_t next_input = 0;
+  auto lStartInput = [&](Lane* lane) {
+    const auto& input = inputs[next_input];
+    *lane = Lane{static_cast<int>(next_input), input.data(),
+                 static_cast<Offset>(input.size()), 0, 0, start_state};
+    next_input++;
+  };
+  for (; num_lanes < kNumLanes && next_input < inputs.size(); num_lanes++) {
+    lStartInput(&lanes[num_lanes]);
+  }
+  while (num_lanes > 0) {
+    for (int l = 0; l < num_lanes; l++) {
+      Lane& lane = lanes[l];
+      if (lane.i < lane.len) {
+        uint8_t c = static_cast<uint8_t>(lane.data[lane.i]);
+        int32_t next_state = transition_table[lane.state * num_classes +
+                                              alphabet_class[c]];
+        if (next_state != LexerMachine::DFA::kDeadState) {
+          lane.state = next_state;
+          lane.i++;
+          continue;
+        }
+      }
+      if (lEndToken(&lane)) {
+        continue;
+      }
+      if (next_input < inputs.size()) {
+        lStartInput(&lane);
+      } else {
+        lane = lanes[--num_lanes];
+        l--;
+      }
+    }
+  }
+  return success;
+}
+
+}  // namespace aparse
@@ -0,0 +1,143 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/batch_lexer.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "aparse/lexer_builder.hpp"
+#include "gtest/gtest.h"
+
+using aparse::Alphabet;
+using aparse::Lexer;
+using aparse::LexerGrammar;
+using aparse::TokenBuffer;
+using std::string;
+using std::vector;
+
+enum TokenType {NUMBER, IDENTIFIER, STRING, PLUS, KEYWORD};
+
+namespace {
+
+LexerGrammar LexerRules() {
+  using Rule = LexerGrammar::Rule;
+  LexerGrammar lexer_rules;
+  lexer_rules.rules = {
+    {0, {
+      Rule("[0-9]+").Token(NUMBER),
+      Rule("[a-z]+").Token(IDENTIFIER).Keyword(Rule("if").Token(KEYWORD)),
+      Rule("\"[^\"]*\"").Token(STRING),
+      Rule("\\+").Token(PLUS),
+      Rule(" +").Skip(),
+    }}
+  };
+  return lexer_rules;
+}
+
+// Short formulas, some of them invalid ("?") or incomplete ("\"a").
+vector<string> RandomInputs(int num_inputs) {
+  std::mt19937 rng(1196);
+  vector<string> pieces = {"44", "if", "\"a + 1\"", "+", " ", "x", "ifx",
+                           "7", "?", "\"a"};
+  vector<string> output;
+  for (int i = 0; i < num_inputs; i++) {
+    string input;
+    int num_pieces = rng() % 8;
+    for (int j = 0; j < num_pieces; j++) {
+      input += pieces[rng() % (j + 1 < num_pieces ? pieces.size() - 2
+                                                  : pieces.size())];
+      input += " ";
+    }
+    if (rng() % 4 == 0) {
+      input += pieces[rng() % pieces.size()];
+    }
+    output.push_back(input);
+  }
+  return output;
+}
+
+struct Tokens {
+  vector<Alphabet> token_ids;
+  vector<aparse::Offset> starts, ends;
+  bool operator==(const Tokens& other) const {
+    return token_ids == other.token_ids && starts == other.starts &&
+           ends == other.ends;
+  }
+};
+
+Tokens ToTokens(const TokenBuffer& token_buffer) {
+  Tokens output;
+  output.token_ids = token_buffer.Alphabets();
+  output.starts.assign(token_buffer.starts(),
+                       token_buffer.starts() + token_buffer.size());
+  output.ends.assign(token_buffer.ends(),
+                     token_buffer.ends() + token_buffer.size());
+  return output;
+}
+
+}  // namespace
+
+TEST(BatchLexerIntegrationTest, SameAsSequential) {
+  Lexer lexer;
+  aparse::LexerBuilder::Build(LexerRules(), &lexer);
+  aparse::BatchLexer batch_lexer(lexer);
+  for (size_t capacity : {3, 100}) {
+    vector<string> inputs = RandomInputs(500);
+    vector<aparse::utils::string_view> input_views(inputs.begin(),
+                                                   inputs.end());
+    vector<TokenBuffer> outputs;
+    for (size_t i = 0; i < inputs.size(); i++) {
+      outputs.emplace_back(capacity);
+    }
+    vector<aparse::Error> errors;
+    bool success = batch_lexer.LexBatch(input_views, &outputs, &errors);
+    ASSERT_EQ(inputs.size(), errors.size());
+    int num_failures = 0;
+    for (size_t i = 0; i < inputs.size(); i++) {
+      aparse::LexerScopeBase scope;
+      TokenBuffer expected_output(capacity);
+      auto lexer_instance = lexer.CreateInstance(&scope, &expected_output);
+      aparse::Error expected_error;
+      if (not (lexer_instance.Feed(inputs[i], &expected_error) &&
+               lexer_instance.End(&expected_error))) {
+        num_failures++;
+      }
+      EXPECT_EQ(expected_error.status, errors[i].status) << inputs[i];
+      EXPECT_EQ(expected_error.error_position, errors[i].error_position);
+      EXPECT_TRUE(ToTokens(expected_output) == ToTokens(outputs[i]))
+          << inputs[i];
+    }
+    EXPECT_GT(num_failures, 0);
+    EXPECT_EQ(num_failures == 0, success);
+  }
+}
+
+TEST(BatchLexerIntegrationTest, Sections) {
+  using Rule = LexerGrammar::Rule;
+  LexerGrammar lexer_rules;
+  lexer_rules.rules = {
+    {0, {
+      Rule("[0-9]+").Token(NUMBER),
+      Rule("\"").Token(STRING).JumpTo(1),
+    }},
+    {1, {
+      Rule("[^\"]+").Token(STRING),
+      Rule("\"").Token(STRING).JumpTo(0),
+    }}
+  };
+  Lexer lexer;
+  aparse::LexerBuilder::Build(lexer_rules, &lexer);
+  aparse::BatchLexer batch_lexer(lexer);
+  vector<aparse::utils::string_view> inputs = {"12", "\"ab\""};
+  vector<TokenBuffer> outputs;
+  outputs.emplace_back(10);
+  outputs.emplace_back(10);
+  vector<aparse::Error> errors;
+  EXPECT_FALSE(batch_lexer.LexBatch(inputs, &outputs, &errors));
+  ASSERT_EQ(2, errors.size());
+  for (auto& error : errors) {
+    EXPECT_EQ(aparse::Error::LEXER_ERROR_UNSUPPORTED_SECTIONS, error.status);
+  }
+}
@@ -9,7 +9,7 @@ namespace aparse {
 // Run this python code for generating case-switch code. Add more enum here and
 // regenerate it.
 //
-// a = 'SUCCESS, INTERNAL_BUG, LEXER_BUILDER_ERROR, LEXER_BUILDER_ERROR_MUST_HAVE_NON_ZERO_RULES, LEXER_ERROR, LEXER_ERROR_INVALID_TOKENS, LEXER_ERROR_INCOMPLETE_TOKENS, INTERNAL_GRAMMAR_REGEX_LABEL_MUST_BE_ZERO, GRAMMAR_INVALID_USE_OF_BRANCHING_ALPHABET, INTERNAL_GRAMMAR_MUST_HAVE_POSITIVE_ALPHABET_SIZE, INTERNAL_GRAMMAR_MUST_HAVE_NON_ZERO_RULES, INTERNAL_GRAMMAR_INVALID_NON_TERMINAL, INTERNAL_GRAMMAR_INVALID_MAIN_NON_TERMINAL, INTERNAL_GRAMMAR_UNDEFINED_NON_TERMINAL, INTERNAL_GRAMMAR_INVALID_BRANCHING_ALPHABETS, GRAMMAR_REPEATED_BRANCHING_ALPHABETS, INTERNAL_GRAMMAR_NON_ENCLOSED_CYCLIC_DEPENDENCY, GRAMMAR_DIRECT_COPY_RULES_ARE_NOT_SUPPORTED_YET, GRAMMAR_REPEATED_NON_TERMINALS_ARE_NOT_SUPPORTED_YET, PARSING_ERROR_INCOMPLETE_TOKENS, PARSING_ERROR_INVALID_TOKENS, PARSER_BUILDER_ERROR_INVALID_RULE, INVALID_RULE_ACTION_TYPE, INVALID_LEXER_RUN_ACTION_TYPE'; print("\n".join("case "+i.strip()+":\n  return \""+i.strip()+"\";" for i in a.split(",")))  #  // NOLINT
+// a = 'SUCCESS, INTERNAL_BUG, LEXER_BUILDER_ERROR, LEXER_BUILDER_ERROR_MUST_HAVE_NON_ZERO_RULES, LEXER_ERROR, LEXER_ERROR_INVALID_TOKENS, LEXER_ERROR_INCOMPLETE_TOKENS, LEXER_ERROR_TOKEN_BUFFER_FULL, INTERNAL_GRAMMAR_REGEX_LABEL_MUST_BE_ZERO, GRAMMAR_INVALID_USE_OF_BRANCHING_ALPHABET, INTERNAL_GRAMMAR_MUST_HAVE_POSITIVE_ALPHABET_SIZE, INTERNAL_GRAMMAR_MUST_HAVE_NON_ZERO_RULES, INTERNAL_GRAMMAR_INVALID_NON_TERMINAL, INTERNAL_GRAMMAR_INVALID_MAIN_NON_TERMINAL, INTERNAL_GRAMMAR_UNDEFINED_NON_TERMINAL, INTERNAL_GRAMMAR_INVALID_BRANCHING_ALPHABETS, GRAMMAR_REPEATED_BRANCHING_ALPHABETS, INTERNAL_GRAMMAR_NON_ENCLOSED_CYCLIC_DEPENDENCY, GRAMMAR_DIRECT_COPY_RULES_ARE_NOT_SUPPORTED_YET, GRAMMAR_REPEATED_NON_TERMINALS_ARE_NOT_SUPPORTED_YET, PARSING_ERROR_INCOMPLETE_TOKENS, PARSING_ERROR_INVALID_TOKENS, PARSER_BUILDER_ERROR_INVALID_RULE, INVALID_RULE_ACTION_TYPE, INVALID_LEXER_RUN_ACTION_TYPE'; print("\n".join("case "+i.strip()+":\n  return \""+i.strip()+"\";" for i in a.split(",")))  #  // NOLINT
 string Error::ErrorCodeString(Error::ErrorStatus input) {
   switch (input) {
     case SUCCESS:
@@ -20,12 +20,22 @@ string Error::ErrorCodeString(Error::ErrorStatus input) {
       return "LEXER_BUILDER_ERROR";
     case LEXER_BUILDER_ERROR_MUST_HAVE_NON_ZERO_RULES:
       return "LEXER_BUILDER_ERROR_MUST_HAVE_NON_ZERO_RULES";
+    case LEXER_BUILDER_ERROR_INVALID_KEYWORD:
+      return "LEXER_BUILDER_ERROR_INVALID_KEYWORD";
+    case LEXER_BUILDER_ERROR_INVALID_SECTION:
+      return "LEXER_BUILDER_ERROR_INVALID_SECTION";
     case LEXER_ERROR:
       return "LEXER_ERROR";
     case LEXER_ERROR_INVALID_TOKENS:
       return "LEXER_ERROR_INVALID_TOKENS";
     case LEXER_ERROR_INCOMPLETE_TOKENS:
       return "LEXER_ERROR_INCOMPLETE_TOKENS";
+    case LEXER_ERROR_TOKEN_BUFFER_FULL:
+      return "LEXER_ERROR_TOKEN_BUFFER_FULL";
+    case LEXER_ERROR_INPUT_READ_FAILED:
+      return "LEXER_ERROR_INPUT_READ_FAILED";
+    case LEXER_ERROR_UNSUPPORTED_SECTIONS:
+      return "LEXER_ERROR_UNSUPPORTED_SECTIONS";
     case INTERNAL_GRAMMAR_REGEX_LABEL_MUST_BE_ZERO:
       return "INTERNAL_GRAMMAR_REGEX_LABEL_MUST_BE_ZERO";
     case GRAMMAR_INVALID_USE_OF_BRANCHING_ALPHABET:
@@ -82,6 +92,8 @@ Error& Error::operator()() {
   switch (status) {
     case LEXER_ERROR_INCOMPLETE_TOKENS:
     case LEXER_ERROR_INVALID_TOKENS:
+    case LEXER_ERROR_TOKEN_BUFFER_FULL:
+    case LEXER_ERROR_INPUT_READ_FAILED:
     case LEXER_BUILDER_ERROR_INVALID_REGEX:
       oss << " at " << error_position.first << ":" << error_position.second;
       break;
@@ -17,5 +17,13 @@ std::string GetAlphabetString(const std::string& s) {
   }
 }
 
+uint64_t SimpleChecksum(const std::string& input) {
+  uint64_t h = 14695981039346656037U;
+  for (int i = 0; i < input.size(); i++) {
+    h = static_cast<unsigned char>(input[i]) ^ (h * 1099511628211U);
+  }
+  return h;
+}
+
 }  // namespace helpers
 }  // namespace aparse
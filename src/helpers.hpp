@@ -4,6 +4,7 @@
 #ifndef APARSE_SRC_HELPERS_HPP_
 #define APARSE_SRC_HELPERS_HPP_
 
+#include <cstdint>
 #include <string>
 
 namespace aparse {
@@ -13,6 +14,10 @@ namespace helpers {
  *  applied if the input string was not alphanumeric. */
 std::string GetAlphabetString(const std::string& s);
 
+/** FNV-1a hash of the input string. Used as a checksum of grammars while
+ *  exporting/importing lexers and parsers. */
+uint64_t SimpleChecksum(const std::string& input);
+
 }  // namespace helpers
 }  // namespace aparse
 
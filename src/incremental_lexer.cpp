@@ -0,0 +1,153 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/incremental_lexer.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace aparse {
+
+namespace {
+
+using Token = IncrementalLexer::Token;
+
+// State of re-lexing an edit.
+struct Relexing {
+  const Lexer* lexer;
+  // Old token stream, and the start of the text after the edit, in the old
+  // offsets.
+  const std::vector<Token>* old_tokens;
+  Offset edit_end;
+  // new offset = old offset + delta, after the edit.
+  Offset delta;
+  // Index of the first old token which may coincide with a new token.
+  size_t next_old_token;
+  // Section of the next token.
+  int32_t section;
+  std::vector<Token> new_tokens;
+  bool synced = false;
+};
+
+// Action table recording the tokens. It rejects the first token after which
+// the new token stream is in sync with the old one, so that the lexing stops
+// there.
+class RelexingActionTable {
+ public:
+  RelexingActionTable() = default;
+  explicit RelexingActionTable(Relexing* relexing) : relexing(relexing) {}
+
+  bool Invoke(int label, LexerScopeBase* scope) const {
+    const auto& lexing_constructs = scope->__lexing_constructs;
+    const auto& range = lexing_constructs.range;
+    const Lexer& lexer = *relexing->lexer;
+    relexing->new_tokens.push_back(Token{range.first, range.second,
+                                         lexer.token_ids[label],
+                                         lexer.skip_tokens[label] != 0,
+                                         relexing->section});
+    relexing->section = lexing_constructs.next_section;
+    Offset old_offset = range.second - relexing->delta;
+    if (old_offset < relexing->edit_end) {
+      return true;
+    }
+    const auto& old_tokens = *relexing->old_tokens;
+    size_t& j = relexing->next_old_token;
+    while (j < old_tokens.size() && old_tokens[j].start < old_offset) {
+      j++;
+    }
+    if (j < old_tokens.size() && old_tokens[j].start == old_offset &&
+        old_tokens[j].section == relexing->section) {
+      relexing->synced = true;
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  // not owned.
+  Relexing* relexing = nullptr;
+};
+
+}  // namespace
+
+IncrementalLexer::IncrementalLexer(const Lexer& lexer) : lexer(&lexer) {
+  APARSE_ASSERT(lexer.IsInitialized());
+}
+
+bool IncrementalLexer::Reset(utils::string_view text, Change* change,
+                             Error* error) {
+  return Edit(0, text_.size(), text, change, error);
+}
+
+bool IncrementalLexer::Edit(size_t offset,
+                            size_t removed_length,
+                            utils::string_view inserted_text,
+                            Change* change,
+                            Error* error) {
+  APARSE_ASSERT(offset + removed_length <= text_.size());
+  text_.replace(offset, removed_length, inserted_text.data(),
+                inserted_text.size());
+  // A token ends only once the lexer sees the byte after it (or the end of
+  // the text), so the first affected token is the first one ending at or
+  // after the edit.
+  size_t first = std::lower_bound(tokens_.begin(), tokens_.end(), offset,
+                                  [](const Token& token, size_t offset) {
+                                    return token.end < offset;
+                                  }) - tokens_.begin();
+  Offset start;
+  int32_t section;
+  if (first < tokens_.size()) {
+    start = tokens_[first].start;
+    section = tokens_[first].section;
+  } else {
+    // The edit is after the failed token, or the text was empty.
+    start = tokens_.empty() ? 0 : tokens_.back().end;
+    section = complete_ ? lexer->main_section_index : failed_section;
+  }
+  Relexing relexing;
+  relexing.lexer = lexer;
+  relexing.old_tokens = &tokens_;
+  relexing.edit_end = offset + removed_length;
+  relexing.delta = static_cast<Offset>(inserted_text.size()) -
+                   static_cast<Offset>(removed_length);
+  relexing.next_old_token = first;
+  relexing.section = section;
+  LexerScopeBase scope;
+  LexerInstance<LexerScopeBase, RelexingActionTable> lexer_instance(
+      *lexer, &scope, RelexingActionTable(&relexing));
+  lexer_instance.Restart(start, section);
+  Error lexing_error;
+  bool success = lexer_instance.Feed(text_.data() + start,
+                                     text_.size() - start, &lexing_error) &&
+                 lexer_instance.End(&lexing_error);
+  size_t last = relexing.synced ? relexing.next_old_token : tokens_.size();
+  tokens_.erase(tokens_.begin() + first, tokens_.begin() + last);
+  tokens_.insert(tokens_.begin() + first, relexing.new_tokens.begin(),
+                 relexing.new_tokens.end());
+  for (size_t i = first + relexing.new_tokens.size(); i < tokens_.size();
+       i++) {
+    tokens_[i].start += relexing.delta;
+    tokens_[i].end += relexing.delta;
+  }
+  change->begin = first;
+  change->num_removed = last - first;
+  change->num_inserted = relexing.new_tokens.size();
+  if (relexing.synced) {
+    // The rest of the token stream, including its failure if any, is the
+    // same.
+    if (not complete_) {
+      error_.error_position.first += relexing.delta;
+      error_.error_position.second += relexing.delta;
+    }
+  } else {
+    complete_ = success;
+    error_ = lexing_error;
+    failed_section = relexing.section;
+  }
+  if (not complete_) {
+    *error = error_;
+  }
+  return complete_;
+}
+
+}  // namespace aparse
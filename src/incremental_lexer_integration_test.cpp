@@ -0,0 +1,144 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/incremental_lexer.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "aparse/lexer_builder.hpp"
+#include "gtest/gtest.h"
+
+using aparse::IncrementalLexer;
+using aparse::Lexer;
+using aparse::LexerGrammar;
+using std::string;
+using std::vector;
+
+enum TokenType {NUMBER = 1, IDENTIFIER, KEYWORD, SPACE, QUOTE, STRING_BODY};
+
+namespace {
+
+const int kCode = 0, kString = 1;
+
+LexerGrammar LexerRules() {
+  using Rule = LexerGrammar::Rule;
+  LexerGrammar lexer_rules;
+  lexer_rules.main_section = kCode;
+  lexer_rules.rules = {
+    {kCode, {
+      Rule("[0-9]+").Token(NUMBER),
+      Rule("[a-z]+").Token(IDENTIFIER).Keyword(Rule("if").Token(KEYWORD)),
+      Rule(" +").Token(SPACE).Skip(),
+      Rule("\"").Token(QUOTE).JumpTo(kString),
+    }},
+    {kString, {
+      Rule("[^\"]+").Token(STRING_BODY),
+      Rule("\"").Token(QUOTE).JumpTo(kCode),
+    }}
+  };
+  return lexer_rules;
+}
+
+string TokensString(const vector<IncrementalLexer::Token>& tokens) {
+  string output;
+  for (auto& token : tokens) {
+    output += std::to_string(token.token_id) + (token.skip ? "s" : "") + "[" +
+              std::to_string(token.start) + "," + std::to_string(token.end) +
+              ")@" + std::to_string(token.section) + " ";
+  }
+  return output;
+}
+
+}  // namespace
+
+TEST(IncrementalLexerIntegrationTest, Basic) {
+  Lexer lexer;
+  aparse::LexerBuilder::Build(LexerRules(), &lexer);
+  IncrementalLexer incremental_lexer(lexer);
+  IncrementalLexer::Change change;
+  aparse::Error error;
+  string text = "if 12 abc \"x y\" 7 if";
+  ASSERT_TRUE(incremental_lexer.Reset(text, &change, &error));
+  EXPECT_EQ(0, change.begin);
+  EXPECT_EQ(0, change.num_removed);
+  EXPECT_EQ(13, change.num_inserted);
+  // "abc" -> "abd": only that token is re-lexed.
+  ASSERT_TRUE(incremental_lexer.Edit(8, 1, "d", &change, &error));
+  EXPECT_EQ(4, change.begin);
+  EXPECT_EQ(1, change.num_removed);
+  EXPECT_EQ(1, change.num_inserted);
+  // "12" -> "1234": the tokens after it are shifted.
+  ASSERT_TRUE(incremental_lexer.Edit(5, 0, "34", &change, &error));
+  EXPECT_EQ(2, change.begin);
+  EXPECT_EQ(1, change.num_removed);
+  EXPECT_EQ(1, change.num_inserted);
+  auto& tokens = incremental_lexer.tokens();
+  EXPECT_EQ(IDENTIFIER, tokens[4].token_id);
+  EXPECT_EQ(8, tokens[4].start);
+  EXPECT_EQ(11, tokens[4].end);
+  EXPECT_EQ(KEYWORD, tokens.back().token_id);
+  // Removing the opening quote turns the string into code, and its closing
+  // quote into an opening one, which is never closed. The space before the
+  // quote is re-lexed too.
+  ASSERT_TRUE(incremental_lexer.Edit(12, 1, "", &change, &error));
+  EXPECT_EQ(5, change.begin);
+  EXPECT_EQ(8, change.num_removed);
+  EXPECT_EQ(6, change.num_inserted);
+  EXPECT_EQ(kString, tokens.back().section);
+  // Invalid token.
+  EXPECT_FALSE(incremental_lexer.Edit(2, 0, "?", &change, &error));
+  EXPECT_FALSE(incremental_lexer.complete());
+  EXPECT_EQ(aparse::Error::LEXER_ERROR_INVALID_TOKENS, error.status);
+  EXPECT_EQ(1, tokens.size());
+  EXPECT_EQ(2, tokens.back().end);
+  EXPECT_TRUE(incremental_lexer.Edit(2, 1, "", &change, &error));
+  EXPECT_TRUE(incremental_lexer.complete());
+}
+
+// Random edits give the same token stream as lexing the whole text.
+TEST(IncrementalLexerIntegrationTest, SameAsFullLexing) {
+  Lexer lexer;
+  aparse::LexerBuilder::Build(LexerRules(), &lexer);
+  std::mt19937 rng(1196);
+  vector<string> pieces = {"if", "12", "ab", " ", "  ", "\"", "\"x y\"", "7",
+                           "f", "?"};
+  IncrementalLexer incremental_lexer(lexer);
+  IncrementalLexer::Change change;
+  aparse::Error error;
+  incremental_lexer.Reset("", &change, &error);
+  for (int i = 0; i < 2000; i++) {
+    const string& text = incremental_lexer.text();
+    size_t offset = rng() % (text.size() + 1);
+    size_t removed_length = rng() % (std::min<size_t>(text.size() - offset,
+                                                      4) + 1);
+    string inserted_text = (rng() % 3 == 0 ? string()
+                                           : pieces[rng() % pieces.size()]);
+    if (text.size() > 200) {
+      removed_length = text.size() - offset;
+    }
+    auto old_tokens = incremental_lexer.tokens();
+    bool success = incremental_lexer.Edit(offset, removed_length,
+                                          inserted_text, &change, &error);
+    IncrementalLexer full_lexer(lexer);
+    IncrementalLexer::Change full_change;
+    aparse::Error expected_error;
+    bool expected_success = full_lexer.Reset(text, &full_change,
+                                             &expected_error);
+    ASSERT_EQ(expected_success, success) << text;
+    ASSERT_EQ(TokensString(full_lexer.tokens()),
+              TokensString(incremental_lexer.tokens())) << text;
+    if (not success) {
+      EXPECT_EQ(expected_error.status, error.status);
+      EXPECT_EQ(expected_error.error_position, error.error_position);
+    }
+    // The change covers all the differences.
+    auto& tokens = incremental_lexer.tokens();
+    ASSERT_EQ(old_tokens.size() - change.num_removed + change.num_inserted,
+              tokens.size());
+    for (size_t j = 0; j < change.begin; j++) {
+      EXPECT_EQ(old_tokens[j].end, tokens[j].end);
+    }
+  }
+}
@@ -3,41 +3,255 @@
 
 #include "src/internal_lexer_builder.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <map>
 #include <memory>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "quick/byte_stream.hpp"
 
 #include "src/lexer_machine_builder.hpp"
 
 namespace aparse {
-// sttaic
+namespace {
+
+struct SectionBuild {
+  int section;
+  Regex regex_union = Regex(Regex::UNION);
+  LexerMachine::DFA minimized_dfa;
+  int dfa_size = 0;
+  size_t peak_memory = 0;
+  std::exception_ptr exception;
+};
+
+void BuildSection(SectionBuild* section_build) {
+  try {
+    auto nfa = LexerMachineBuilder::BuildNFA(section_build->regex_union);
+    LexerMachine::DFA dfa;
+    LexerMachineBuilder::BuildDFA(nfa, &dfa, &section_build->peak_memory);
+    LexerMachineBuilder::MinimizeDFA(dfa, &section_build->minimized_dfa);
+    section_build->dfa_size = dfa.states.size();
+  } catch (...) {
+    section_build->exception = std::current_exception();
+  }
+}
+
+}  // namespace
+
+// static
+void InternalLexerBuilder::BuildKeywordTables(
+    const std::map<int, vector<pair<string, int>>>& keywords,
+    const unordered_map<int, int>& keyword_sections,
+    Lexer* output) {
+  const auto& dfa = output->machine.dfa;
+  output->keyword_tables.resize(output->token_ids.size());
+  for (auto& item : keywords) {
+    int identifier_label = item.first;
+    int32_t start_state = output->StartState(
+                                      keyword_sections.at(identifier_label));
+    std::unordered_set<string> unique_keywords;
+    for (auto& keyword : item.second) {
+      // The keyword must be recognised as a lexeme of the identifier rule.
+      int32_t state = start_state;
+      for (char c : keyword.first) {
+        if (state == LexerMachine::DFA::kDeadState) {
+          break;
+        }
+        state = dfa.Next(state, static_cast<unsigned char>(c));
+      }
+      if (keyword.first.empty() ||
+          not unique_keywords.insert(keyword.first).second ||
+          state == LexerMachine::DFA::kDeadState ||
+          not dfa.IsFinal(state) ||
+          dfa.states[state].label != identifier_label) {
+        Error error(Error::LEXER_BUILDER_ERROR_INVALID_KEYWORD);
+        error.string_value = keyword.first;
+        throw error();
+      }
+    }
+    output->keyword_tables[identifier_label].Build(item.second);
+  }
+}
+
+// static
 bool InternalLexerBuilder::Build(const InternalLexerGrammar& lexer_grammar,
                                  Lexer* output) {
   if (lexer_grammar.rules.size() == 0) {
     throw Error(Error::LEXER_BUILDER_ERROR_MUST_HAVE_NON_ZERO_RULES)();
   }
+  auto start_time = std::chrono::steady_clock::now();
   int index_counter = 1;
-  unordered_map<int, LexerMachine::DFA> dfa_map;
-  vector<int> section_id_list;
+  vector<SectionBuild> section_builds(lexer_grammar.rules.size());
+  // Map(label of an identifier rule -> List(Pair(keyword, label)))
+  std::map<int, vector<pair<string, int>>> keywords;
+  // Label of the identifier rule -> its section.
+  unordered_map<int, int> keyword_sections;
+  // Sections are numbered densely, in the increasing order of their ids.
+  auto& sections = output->sections;
+  sections.clear();
   for (auto& section : lexer_grammar.rules) {
-    Regex regex_union(Regex::UNION);
-    for (auto& rule : section.second) {
+    sections.push_back(section.first);
+  }
+  std::sort(sections.begin(), sections.end());
+  auto lSectionIndex = [&](int section) {
+    auto it = std::lower_bound(sections.begin(), sections.end(), section);
+    if (it == sections.end() || *it != section) {
+      Error error(Error::LEXER_BUILDER_ERROR_INVALID_SECTION);
+      error.string_value = std::to_string(section);
+      throw error();
+    }
+    return static_cast<int32_t>(it - sections.begin());
+  };
+  lSectionIndex(lexer_grammar.main_section);
+  // Label 0 is unused.
+  output->actions.assign(1, utils::any());
+  output->label_to_rule.assign(1, make_pair(-1, -1));
+  output->token_ids.assign(1, 0);
+  output->skip_tokens.assign(1, 0);
+  output->jump_to_sections.assign(1, -1);
+  for (int section_index = 0; section_index < sections.size();
+       section_index++) {
+    int section = sections[section_index];
+    auto& rules = lexer_grammar.rules.at(section);
+    auto& section_build = section_builds[section_index];
+    section_build.section = section;
+    int first_label = index_counter;
+    for (int i = 0; i < rules.size(); i++) {
+      auto& rule = rules[i];
       auto regex = rule.regex;
       regex.label = index_counter++;
-      output->pattern_actions[regex.label] = rule.action;
-      regex_union.children.emplace_back(regex);
+      output->actions.push_back(rule.action);
+      output->label_to_rule.push_back(make_pair(section, i));
+      output->token_ids.push_back(rule.token_id);
+      output->skip_tokens.push_back(rule.skip);
+      output->jump_to_sections.push_back(
+          rule.has_jump_to ? lSectionIndex(rule.jump_to) : -1);
+      if (rule.identifier_rule >= 0) {
+        APARSE_ASSERT(rule.identifier_rule < rules.size() &&
+                      rules[rule.identifier_rule].identifier_rule < 0);
+        int identifier_label = first_label + rule.identifier_rule;
+        keywords[identifier_label].emplace_back(rule.keyword, regex.label);
+        keyword_sections[identifier_label] = section;
+      } else {
+        section_build.regex_union.children.emplace_back(regex);
+      }
+    }
+  }
+  // The sections are independent of each other until MergeDFA, so they are
+  // built concurrently on a pool of threads.
+  {
+    int num_threads = std::min<int>(section_builds.size(),
+                                    std::thread::hardware_concurrency());
+    std::atomic<int> next_section(0);
+    auto lWorker = [&]() {
+      for (int i = next_section++; i < section_builds.size();
+           i = next_section++) {
+        BuildSection(&section_builds[i]);
+      }
+    };
+    vector<std::thread> threads;
+    for (int i = 1; i < num_threads; i++) {
+      threads.emplace_back(lWorker);
+    }
+    lWorker();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  vector<LexerMachine::DFA> dfa_list(sections.size());
+  auto& build_stats = output->machine.build_stats;
+  for (int i = 0; i < sections.size(); i++) {
+    auto& section_build = section_builds[i];
+    if (section_build.exception) {
+      std::rethrow_exception(section_build.exception);
     }
-    auto nfa = LexerMachineBuilder::BuildNFA(regex_union);
-    LexerMachineBuilder::BuildDFA(nfa, &dfa_map[section.first]);
+    int section = section_build.section;
+    dfa_list[i] = std::move(section_build.minimized_dfa);
+    build_stats.section_dfa_sizes[section] =
+        make_pair(section_build.dfa_size, dfa_list[i].states.size());
+    build_stats.section_peak_memory[section] = section_build.peak_memory;
+    build_stats.peak_memory += section_build.peak_memory;
   }
   output->main_section = lexer_grammar.main_section;
   LexerMachineBuilder::MergeDFA(
-    dfa_map,
-    lexer_grammar.main_section,
+    dfa_list,
+    lSectionIndex(lexer_grammar.main_section),
     &output->machine.dfa,
-    &output->section_to_start_state_mapping);
+    &output->section_start_states);
+  LexerMachineBuilder::CompileDFA(&output->machine.dfa);
+  if (not keywords.empty()) {
+    BuildKeywordTables(keywords, keyword_sections, output);
+  }
   output->machine.initialized = true;
+  build_stats.build_time_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start_time).count();
   return output->Finalize();
 }
 
+// static
+bool InternalLexerBuilder::Import(
+    const string& serialized_lexer,
+    uint64_t lexer_grammar_hash,
+    const unordered_map<int, vector<utils::any>>& rule_actions,
+    Lexer* lexer) {
+  if (serialized_lexer.empty()) {
+    return false;
+  }
+  qk::IByteStream bs;
+  bs.str(serialized_lexer);
+  uint32_t expected_version = 5, current_version;
+  bs >> current_version;
+  if (expected_version != current_version) {
+    return false;
+  }
+  uint64_t expected_lexer_grammar_hash;
+  bs >> expected_lexer_grammar_hash;
+  if (lexer_grammar_hash != expected_lexer_grammar_hash) {
+    return false;
+  }
+  vector<pair<int, int>> label_to_rule;
+  bs >> label_to_rule;
+  vector<utils::any> actions(label_to_rule.size());
+  for (int label = 1; label < label_to_rule.size(); label++) {
+    auto& rule = label_to_rule[label];
+    auto section = rule_actions.find(rule.first);
+    if (section == rule_actions.end() or
+        rule.second >= section->second.size()) {
+      return false;
+    }
+    actions[label] = section->second[rule.second];
+  }
+  bs >> lexer->machine.dfa >> lexer->sections >> lexer->section_start_states
+     >> lexer->main_section >> lexer->token_ids >> lexer->skip_tokens
+     >> lexer->jump_to_sections >> lexer->keyword_tables;
+  lexer->label_to_rule = std::move(label_to_rule);
+  lexer->actions = std::move(actions);
+  lexer->machine.initialized = true;
+  return lexer->Finalize();
+}
+
+// format-version = 5
+// static
+void InternalLexerBuilder::Export(const Lexer& lexer,
+                                  uint64_t lexer_grammar_hash,
+                                  string* serialized_lexer) {
+  qk::OByteStream bs;
+  uint32_t version = 5;
+  bs << version << lexer_grammar_hash << lexer.label_to_rule
+     << lexer.machine.dfa << lexer.sections << lexer.section_start_states
+     << lexer.main_section << lexer.token_ids << lexer.skip_tokens
+     << lexer.jump_to_sections << lexer.keyword_tables;
+  *serialized_lexer = std::move(bs.str());
+}
+
 
 }  // namespace aparse
@@ -5,10 +5,12 @@
 #define APARSE_SRC_INTERNAL_LEXER_BUILDER_HPP_
 
 #include <tuple>
+#include <map>
 #include <memory>
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <cstdint>
 
 #include <quick/type_traits/function_type.hpp>
 
@@ -37,8 +39,38 @@ class InternalLexerGrammar {
       return *this;
     }
 
+    Rule& Token(Alphabet token_id) {
+      this->token_id = token_id;
+      return *this;
+    }
+
+    Rule& Skip(bool skip = true) {
+      this->skip = skip;
+      return *this;
+    }
+
+    Rule& JumpTo(int section) {
+      this->has_jump_to = true;
+      this->jump_to = section;
+      return *this;
+    }
+
+    /** Makes this rule the @keyword of the @identifier_rule'th rule of the
+     *  same section. `regex` of a keyword rule is not used. */
+    Rule& Keyword(const std::string& keyword, int identifier_rule) {
+      this->keyword = keyword;
+      this->identifier_rule = identifier_rule;
+      return *this;
+    }
+
     Regex regex;
     utils::any action;
+    Alphabet token_id = 0;
+    bool skip = false;
+    std::string keyword;
+    int identifier_rule = -1;
+    bool has_jump_to = false;
+    int jump_to = 0;
   };
   std::unordered_map<int, std::vector<Rule>> rules;
   int main_section = 0;
@@ -48,6 +80,30 @@ class InternalLexerGrammar {
 class InternalLexerBuilder {
  public:
   static bool Build(const InternalLexerGrammar& lexer_grammar, Lexer* lexer);
+
+  /** Import a lexer exported by `Export`. @rule_actions[section][i] is the
+   *  action of the i'th rule of the `section`.
+   *  @returns false if @serialized_lexer was not exported with the same
+   *  @lexer_grammar_hash, or doesn't match with @rule_actions. */
+  static bool Import(
+      const std::string& serialized_lexer,
+      uint64_t lexer_grammar_hash,
+      const std::unordered_map<int, std::vector<utils::any>>& rule_actions,
+      Lexer* lexer);
+
+  static void Export(const Lexer& lexer,
+                     uint64_t lexer_grammar_hash,
+                     std::string* serialized_lexer);
+
+ private:
+  /** Build `Lexer::keyword_tables` once the lexer DFA is compiled.
+   *  @keywords: Map(label of an identifier rule -> List(Pair(keyword, label
+   *  of the keyword rule))).
+   *  @keyword_sections: Map(label of an identifier rule -> its section). */
+  static void BuildKeywordTables(
+      const std::map<int, std::vector<std::pair<std::string, int>>>& keywords,
+      const std::unordered_map<int, int>& keyword_sections,
+      Lexer* output);
 };
 
 }  // namespace aparse
@@ -4,11 +4,13 @@
 #include "src/internal_lexer_builder.hpp"
 
 #include <iostream>
+#include <sstream>
 
 #include "quick/debug.hpp"
 #include "gtest/gtest.h"
 #include "quick/stl_utils.hpp"
 
+#include "aparse/lexer_input.hpp"
 #include "src/regex_helpers.hpp"
 
 using aparse::Lexer;
@@ -18,6 +20,7 @@ using std::vector;
 using std::cout;
 using std::endl;
 using std::pair;
+using std::string;
 
 using uchar = unsigned char;
 enum TokenType {NUMBER, OPEN_B1, CLOSE_B1, PLUS, WHITESPACE};
@@ -25,6 +28,7 @@ enum TokenType {NUMBER, OPEN_B1, CLOSE_B1, PLUS, WHITESPACE};
 struct LexerScope1: public aparse::LexerScopeBase {
   vector<TokenType> tokens;
   vector<pair<int, int>> range_list;
+  vector<pair<uint32_t, uint32_t>> positions;
 };
 
 auto LexerRules1() {
@@ -39,6 +43,8 @@ auto LexerRules1() {
     return [token](LexerScope1* scope) {
       scope->tokens.push_back(token);
       scope->range_list.push_back(scope->Range());
+      scope->positions.emplace_back(scope->LineNumber(),
+                                    scope->ColumnNumber());
     };
   };
   aparse::InternalLexerGrammar lexer_rules;
@@ -134,3 +140,130 @@ TEST(DefaultScope, Basic) {
   }
 }
 
+
+
+TEST(InternalLexerIntegrationTest, InvalidAlphabets) {
+  Lexer lexer;
+  aparse::InternalLexerBuilder::Build(LexerRules1(), &lexer);
+  auto& dfa = lexer.machine.dfa;
+  // {digits, '(', ')', '+', whitespaces, all others}
+  EXPECT_EQ(6, dfa.num_alphabet_classes);
+  EXPECT_EQ(dfa.alphabet_class[uchar('0')], dfa.alphabet_class[uchar('7')]);
+  EXPECT_EQ(dfa.alphabet_class[uchar(' ')], dfa.alphabet_class[uchar('\n')]);
+  EXPECT_EQ(dfa.alphabet_class[uchar('x')], dfa.alphabet_class[255]);
+  EXPECT_NE(dfa.alphabet_class[uchar('(')], dfa.alphabet_class[uchar(')')]);
+  EXPECT_EQ(dfa.states.size() * dfa.num_alphabet_classes,
+            dfa.transition_table.size());
+  LexerScope1 scope;
+  auto lexer_i = lexer.CreateInstance(&scope);
+  EXPECT_TRUE(lexer_i.Feed("44+"));
+  EXPECT_FALSE(lexer_i.Feed(uchar('x')));
+  lexer_i.Reset();
+  EXPECT_TRUE(lexer_i.Feed("44"));
+  EXPECT_FALSE(lexer_i.Feed(1000));
+  EXPECT_TRUE(lexer_i.Feed(uchar('+')));
+  EXPECT_TRUE(lexer_i.End());
+  EXPECT_EQ((vector<TokenType> {NUMBER, PLUS, NUMBER, PLUS}), scope.tokens);
+}
+
+
+TEST(InternalLexerIntegrationTest, ChunkedFeed) {
+  Lexer lexer;
+  aparse::InternalLexerBuilder::Build(LexerRules1(), &lexer);
+  string input = "44 +\n(55\n\n+ 66)\t+ 29";
+  LexerScope1 expected;
+  {
+    auto lexer_i = lexer.CreateInstance(&expected);
+    EXPECT_TRUE(lexer_i.Feed(input));
+    EXPECT_TRUE(lexer_i.End());
+  }
+  EXPECT_EQ(std::make_pair(1u, 0u), expected.positions[0]);
+  EXPECT_EQ(std::make_pair(1u, 3u), expected.positions[2]);
+  EXPECT_EQ(std::make_pair(2u, 0u), expected.positions[4]);
+  EXPECT_EQ(std::make_pair(4u, 0u), expected.positions[7]);
+  EXPECT_EQ(std::make_pair(4u, 8u), expected.positions.back());
+  // Every split of the input in two chunks, and the byte by byte feeding,
+  // must produce the same tokens.
+  for (size_t split = 0; split <= input.size(); split++) {
+    LexerScope1 scope;
+    auto lexer_i = lexer.CreateInstance(&scope);
+    EXPECT_TRUE(lexer_i.Feed(input.data(), split));
+    EXPECT_TRUE(lexer_i.Feed(input.data() + split, input.size() - split));
+    EXPECT_TRUE(lexer_i.End());
+    EXPECT_EQ(expected.tokens, scope.tokens);
+    EXPECT_EQ(expected.range_list, scope.range_list);
+    EXPECT_EQ(expected.positions, scope.positions);
+  }
+  LexerScope1 scope;
+  auto lexer_i = lexer.CreateInstance(&scope);
+  for (char c : input) {
+    EXPECT_TRUE(lexer_i.Feed(uchar(c)));
+  }
+  EXPECT_TRUE(lexer_i.End());
+  EXPECT_EQ(expected.tokens, scope.tokens);
+  EXPECT_EQ(expected.positions, scope.positions);
+}
+
+
+TEST(InternalLexerIntegrationTest, LinesAndColumns) {
+  Lexer lexer;
+  aparse::InternalLexerBuilder::Build(LexerRules1(), &lexer);
+  string input;
+  for (int i = 0; i < 20; i++) {
+    input += "12 + 345" + string(i, ' ') + "\n" + string(i % 3, '\n') +
+             string(3 * i, '\t') + "(" + string(2 * i, '7') + ")\n";
+  }
+  auto lCheckPositions = [&](const LexerScope1& scope) {
+    ASSERT_EQ(scope.range_list.size(), scope.positions.size());
+    for (size_t i = 0; i < scope.range_list.size(); i++) {
+      uint32_t line = 1, column = 0;
+      for (int j = 0; j < scope.range_list[i].first; j++) {
+        if (input[j] == '\n') {
+          line++;
+          column = 0;
+        } else {
+          column++;
+        }
+      }
+      EXPECT_EQ(std::make_pair(line, column), scope.positions[i]);
+    }
+  };
+  for (size_t chunk_size : {1, 7, 16, 33, 1000}) {
+    LexerScope1 scope;
+    auto lexer_i = lexer.CreateInstance(&scope);
+    for (size_t i = 0; i < input.size(); i += chunk_size) {
+      EXPECT_TRUE(lexer_i.Feed(input.data() + i,
+                               std::min(chunk_size, input.size() - i)));
+    }
+    EXPECT_TRUE(lexer_i.End());
+    lCheckPositions(scope);
+  }
+  // The chunks of IstreamInputSource are overwritten by the next ones.
+  for (size_t chunk_size : {1, 7, 16, 33}) {
+    LexerScope1 scope;
+    auto lexer_i = lexer.CreateInstance(&scope);
+    std::istringstream stream(input);
+    aparse::IstreamInputSource source(&stream, chunk_size);
+    aparse::Error error;
+    EXPECT_TRUE(lexer_i.Feed(&source, &error));
+    EXPECT_TRUE(lexer_i.End());
+    lCheckPositions(scope);
+  }
+}
+
+
+TEST(InternalLexerIntegrationTest, PositionAfterChunkIsGone) {
+  Lexer lexer;
+  aparse::InternalLexerBuilder::Build(LexerRules1(), &lexer);
+  LexerScope1 scope;
+  auto lexer_i = lexer.CreateInstance(&scope);
+  // The last token is completed at End, once the chunk is destroyed.
+  EXPECT_TRUE(lexer_i.Feed(string("12\n \n+\n 345")));
+  string chunk = "\n\n (77";
+  EXPECT_TRUE(lexer_i.Feed(chunk));
+  chunk.assign(chunk.size(), '\n');
+  EXPECT_TRUE(lexer_i.End());
+  vector<pair<uint32_t, uint32_t>> expected_positions = {
+    {1, 0}, {1, 2}, {3, 0}, {3, 1}, {4, 1}, {4, 4}, {6, 1}, {6, 2}};
+  EXPECT_EQ(expected_positions, scope.positions);
+}
@@ -8,6 +8,7 @@
 
 #include "src/v2/aparse_machine_builder.hpp"
 #include "src/v2/core_parser.hpp"
+#include "src/v2/deterministic_aparse_machine.hpp"
 
 namespace aparse {
 using std::shared_ptr;
@@ -60,6 +61,13 @@ vector<int> ExtractRuleNonTerminals(
 void InternalParserBuilder::Build(const AParseGrammar& grammar,
                                   const vector<utils::any>& rule_actions,
                                   Parser* parser) {
+  Build(grammar, rule_actions, Parser::VERY_HIGH_COMPRESSION, parser);
+}
+
+void InternalParserBuilder::Build(const AParseGrammar& grammar,
+                                  const vector<utils::any>& rule_actions,
+                                  Parser::AParseMachineType machine_type,
+                                  Parser* parser) {
   if (not parser->IsFinalized()) {
     APARSE_ASSERT(grammar.Validate());
     APARSE_ASSERT(rule_actions.size() == grammar.rules.size());
@@ -72,12 +80,20 @@ void InternalParserBuilder::Build(const AParseGrammar& grammar,
     v2::AParseMachineBuilder builder(grammar);
     auto new_machine = new v2::AParseMachine();
     builder.Build(new_machine);
-    parser->machine.reset(new_machine);
+    parser->machine_type = machine_type;
+    if (machine_type == Parser::VERY_LOW_COMPRESSION) {
+      auto deterministic_machine = new v2::DeterministicAParseMachine();
+      deterministic_machine->Build(*new_machine);
+      delete new_machine;
+      parser->machine.reset(deterministic_machine);
+    } else {
+      parser->machine.reset(new_machine);
+    }
     parser->Finalize();
   }
 }
 
-// format-version = 3
+// format-version = 4
 bool InternalParserBuilder::Import(const string& serialized_parser,
                                    std::size_t aparse_grammar_hash,
                                    const vector<utils::any>& rule_actions,
@@ -87,7 +103,7 @@ bool InternalParserBuilder::Import(const string& serialized_parser,
   }
   qk::IByteStream bs;
   bs.str(serialized_parser);
-  uint32_t expected_version = 3, current_version;
+  uint32_t expected_version = 4, current_version;
   bs >> current_version;
   if (expected_version != current_version) {
     return false;
@@ -102,17 +118,26 @@ bool InternalParserBuilder::Import(const string& serialized_parser,
   if (rule_actions_size != rule_actions.size()) {
     return false;
   }
-  auto new_machine = new v2::AParseMachine();
-  bs >> (parser->rule_atoms) >> (parser->rule_non_terminals) >> (*new_machine);
-  new_machine->initialized = true;
-  parser->machine.reset(new_machine);
+  bs >> (parser->machine_type) >> (parser->rule_atoms)
+     >> (parser->rule_non_terminals);
+  if (parser->machine_type == Parser::VERY_LOW_COMPRESSION) {
+    auto new_machine = new v2::DeterministicAParseMachine();
+    bs >> (*new_machine);
+    new_machine->initialized = true;
+    parser->machine.reset(new_machine);
+  } else {
+    auto new_machine = new v2::AParseMachine();
+    bs >> (*new_machine);
+    new_machine->initialized = true;
+    parser->machine.reset(new_machine);
+  }
   parser->rule_actions = rule_actions;
   parser->Finalize();
   return true;
 }
 
 
-// format-version = 3
+// format-version = 4
 string InternalParserBuilder::Export(const Parser& parser,
                                      std::size_t aparse_grammar_hash) {
   string output;
@@ -121,15 +146,19 @@ string InternalParserBuilder::Export(const Parser& parser,
 }
 
 
-// format-version = 3
+// format-version = 4
 void InternalParserBuilder::Export(const Parser& parser,
                                    std::size_t aparse_grammar_hash,
                                    std::string* serialized_parser) {
   qk::OByteStream bs;
-  uint32_t version = 3;
-  auto casted_machine = static_cast<const v2::AParseMachine&>(*parser.machine);
+  uint32_t version = 4;
   bs << version << aparse_grammar_hash << parser.rule_actions.size()
-     << parser.rule_atoms << parser.rule_non_terminals << casted_machine;
+     << parser.machine_type << parser.rule_atoms << parser.rule_non_terminals;
+  if (parser.machine_type == Parser::VERY_LOW_COMPRESSION) {
+    bs << static_cast<const v2::DeterministicAParseMachine&>(*parser.machine);
+  } else {
+    bs << static_cast<const v2::AParseMachine&>(*parser.machine);
+  }
   *serialized_parser = std::move(bs.str());
 }
 
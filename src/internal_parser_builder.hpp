@@ -29,6 +29,11 @@ class InternalParserBuilder {
              const vector<utils::any>& rule_actions,
              Parser* parser);
 
+  static void Build(const AParseGrammar& grammar,
+             const vector<utils::any>& rule_actions,
+             Parser::AParseMachineType machine_type,
+             Parser* parser);
+
   static bool Import(const std::string& serialized_parser,
               std::size_t aparse_grammar_hash,
               const vector<utils::any>& rule_actions,
@@ -170,7 +170,7 @@ TEST(InternalParserIntegrationTest, ImportExport) {
                                &parser_main);
   std::size_t grammar_hash = qk::HashFunction(g3.aparse_grammar);
   string p3_export = InternalParserBuilder::Export(parser_main, grammar_hash);
-  EXPECT_EQ(p3_export.size(), 3452);
+  EXPECT_EQ(p3_export.size(), 3453);
   Parser p33, p333;
   EXPECT_TRUE(InternalParserBuilder::Import(p3_export,
                                             grammar_hash,
@@ -202,3 +202,39 @@ TEST(InternalParserIntegrationTest, ImportExport) {
     }
   }
 }
+
+TEST(InternalParserIntegrationTest, VeryLowCompression) {
+  Parser parser_main;
+  auto g3 = test::Grammar3();
+  InternalParserBuilder::Build(g3.aparse_grammar,
+                               g3.rule_actions,
+                               Parser::VERY_LOW_COMPRESSION,
+                               &parser_main);
+  EXPECT_TRUE(parser_main.IsFinalized());
+  std::size_t grammar_hash = qk::HashFunction(g3.aparse_grammar);
+  string p3_export = InternalParserBuilder::Export(parser_main, grammar_hash);
+  Parser p33;
+  EXPECT_TRUE(InternalParserBuilder::Import(p3_export,
+                                            grammar_hash,
+                                            g3.rule_actions,
+                                            &p33));
+  EXPECT_EQ(InternalParserBuilder::Export(p33, grammar_hash).size(),
+            p3_export.size());
+  auto p3_i = parser_main.CreateInstance();
+  auto p33_i = p33.CreateInstance();
+  for (auto& item : {&p3_i, &p33_i}) {
+    auto& p = *item;
+    p.Reset();
+    EXPECT_TRUE(p.Feed(g3.MakeStream({
+      "[", "BOOL", ",", "NUM", ",", "{", "STRING", ":", "[", "NULL", ",", "{",
+      "STRING", ":", "NUM", "}", "]", ",", "STRING", ":", "BOOL", "}",
+      "]"})));
+    EXPECT_TRUE(p.End());
+    Grammar3Node syntax_tree;
+    p.CreateSyntaxTree(&syntax_tree);
+    EXPECT_EQ(syntax_tree.DebugString(),
+              "[BOOL, NUM, {STRING: BOOL, STRING: [NULL, {STRING: NUM}]}]");
+    p.Reset();
+    EXPECT_FALSE(p.Feed(g3.MakeStream({"[", "BOOL", "BOOL"})));
+  }
+}
@@ -0,0 +1,130 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/keyword_table.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace aparse {
+
+// static
+bool KeywordTable::Equal(const char* text, const char* keyword, size_t len) {
+#if defined(__SSE2__)
+  auto equal16 = [](__m128i bytes, const char* expected) {
+    __m128i expected_bytes = _mm_loadu_si128(
+                                 reinterpret_cast<const __m128i*>(expected));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, expected_bytes)) == 0xFFFF;
+  };
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    if (not equal16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i)),
+                    keyword + i)) {
+      return false;
+    }
+  }
+  if (i < len) {
+    // Keywords are zero padded upto `stride`.
+    alignas(16) char tail[16] = {};
+    std::memcpy(tail, text + i, len - i);
+    return equal16(_mm_load_si128(reinterpret_cast<const __m128i*>(tail)),
+                   keyword + i);
+  }
+  return true;
+#else
+  return std::memcmp(text, keyword, len) == 0;
+#endif
+}
+
+// Hash and displace: the keywords are distributed into buckets by their hash,
+// and for each bucket, largest first, a displacement is searched such that
+// all of its keywords land into distinct free slots.
+void KeywordTable::Build(
+    const std::vector<std::pair<std::string, int>>& input_keywords) {
+  int n = input_keywords.size();
+  displacements.assign(std::max(n, 1), 0);
+  labels.assign(n, 0);
+  lengths.assign(n, 0);
+  stride = 0;
+  min_length = 1;
+  max_length = 0;
+  if (n == 0) {
+    keywords.clear();
+    return;
+  }
+  min_length = input_keywords[0].first.size();
+  for (auto& item : input_keywords) {
+    APARSE_ASSERT(item.first.size() > 0 && item.second > 0);
+    min_length = std::min<uint32_t>(min_length, item.first.size());
+    max_length = std::max<uint32_t>(max_length, item.first.size());
+  }
+  {
+    vector<std::string> sorted_keywords;
+    for (auto& item : input_keywords) {
+      sorted_keywords.push_back(item.first);
+    }
+    std::sort(sorted_keywords.begin(), sorted_keywords.end());
+    APARSE_ASSERT(std::adjacent_find(sorted_keywords.begin(),
+                                     sorted_keywords.end())
+                  == sorted_keywords.end(), "Duplicate keywords");
+  }
+  stride = (max_length + 15) / 16 * 16;
+  keywords.assign(n * stride, 0);
+  vector<uint64_t> hashes(n);
+  vector<vector<int>> buckets(n);
+  for (int i = 0; i < n; i++) {
+    auto& keyword = input_keywords[i].first;
+    hashes[i] = Hash(keyword.data(), keyword.size());
+    buckets[hashes[i] % n].push_back(i);
+  }
+  vector<int> order(n);
+  for (int i = 0; i < n; i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+  vector<bool> occupied(n, false);
+  vector<int> bucket_slots;
+  for (int bucket : order) {
+    if (buckets[bucket].empty()) {
+      break;
+    }
+    for (uint32_t displacement = 0;; displacement++) {
+      // Distinct keywords with the same 64 bit hash can never be separated.
+      APARSE_ASSERT(displacement < (1u << 24), "Keyword hash collision");
+      bucket_slots.clear();
+      for (int i : buckets[bucket]) {
+        int slot = Slot(hashes[i], displacement);
+        if (occupied[slot] || std::find(bucket_slots.begin(),
+                                        bucket_slots.end(),
+                                        slot) != bucket_slots.end()) {
+          break;
+        }
+        bucket_slots.push_back(slot);
+      }
+      if (bucket_slots.size() == buckets[bucket].size()) {
+        displacements[bucket] = displacement;
+        break;
+      }
+    }
+    for (int j = 0; j < bucket_slots.size(); j++) {
+      int slot = bucket_slots[j];
+      auto& keyword = input_keywords[buckets[bucket][j]];
+      occupied[slot] = true;
+      labels[slot] = keyword.second;
+      lengths[slot] = keyword.first.size();
+      std::copy(keyword.first.begin(), keyword.first.end(),
+                keywords.begin() + slot * stride);
+    }
+  }
+}
+
+}  // namespace aparse
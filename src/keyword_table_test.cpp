@@ -0,0 +1,56 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/keyword_table.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using aparse::KeywordTable;
+using std::string;
+using std::vector;
+
+TEST(KeywordTableTest, Basic) {
+  vector<std::pair<string, int>> keywords = {
+    {"if", 1}, {"int", 2}, {"for", 3}, {"else", 4}, {"while", 5},
+    {"return", 6}, {"a_very_long_keyword_of_33_bytes__", 7},
+    {"sixteen_bytes_16", 8}};
+  KeywordTable table;
+  EXPECT_EQ(0, table.Find("if", 2));
+  table.Build(keywords);
+  EXPECT_EQ(keywords.size(), table.size());
+  EXPECT_EQ(33, table.MaxLength());
+  for (auto& item : keywords) {
+    EXPECT_EQ(item.second, table.Find(item.first.data(), item.first.size()));
+    // Prefixes and extensions of the keywords are not keywords.
+    string longer = item.first + "x";
+    EXPECT_EQ(0, table.Find(longer.data(), longer.size()));
+    EXPECT_EQ(0, table.Find(item.first.data(), item.first.size() - 1));
+    string other = item.first;
+    other.back() = '#';
+    EXPECT_EQ(0, table.Find(other.data(), other.size()));
+  }
+  EXPECT_EQ(0, table.Find("", 0));
+  EXPECT_EQ(0, table.Find("sixteen_bytes_17", 16));
+  // Only [text, text+len) is compared.
+  EXPECT_EQ(1, table.Find("iffy", 2));
+}
+
+TEST(KeywordTableTest, ManyKeywords) {
+  vector<std::pair<string, int>> keywords;
+  for (int i = 0; i < 1000; i++) {
+    keywords.emplace_back("kw" + std::to_string(i * 7919), i + 1);
+  }
+  KeywordTable table;
+  table.Build(keywords);
+  for (auto& item : keywords) {
+    EXPECT_EQ(item.second, table.Find(item.first.data(), item.first.size()));
+  }
+  for (int i = 0; i < 1000; i++) {
+    string identifier = "kw" + std::to_string(i * 7919 + 1);
+    EXPECT_EQ(0, table.Find(identifier.data(), identifier.size()));
+  }
+}
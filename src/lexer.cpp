@@ -3,15 +3,158 @@
 
 #include "aparse/lexer.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace aparse {
 
+namespace {
+
+// Returns the number of new lines in [begin, end) and sets @last_new_line to
+// the last of them (unchanged if there is none). Scans 16 bytes at a time
+// where SSE2 is available.
+uint32_t CountNewLines(const char* begin, const char* end,
+                       const char** last_new_line) {
+  uint32_t count = 0;
+  const char* p = begin;
+#if defined(__SSE2__)
+  const __m128i new_line = _mm_set1_epi8('\n');
+  for (; p + 16 <= end; p += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, new_line));
+    if (mask != 0) {
+      count += __builtin_popcount(mask);
+      *last_new_line = p + (31 - __builtin_clz(mask));
+    }
+  }
+#endif
+  while (p < end) {
+    p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (p == nullptr) break;
+    count++;
+    *last_new_line = p;
+    p++;
+  }
+  return count;
+}
+
+}  // namespace
+
+void LexerScopeBase::LexingConstructs::SyncPosition(Offset offset) const {
+  if (offset <= synced_offset) {
+    return;
+  }
+  if (synced_offset < position_chunk_offset) {
+    if (pending_lines > 0) {
+      line_number += pending_lines;
+      column_number = pending_column;
+    } else {
+      column_number += pending_column;
+    }
+    pending_lines = 0;
+    pending_column = 0;
+    synced_offset = position_chunk_offset;
+  }
+  const char* begin = position_chunk + (synced_offset - position_chunk_offset);
+  const char* end = position_chunk + (offset - position_chunk_offset);
+  const char* last_new_line = nullptr;
+  uint32_t new_lines = CountNewLines(begin, end, &last_new_line);
+  if (new_lines > 0) {
+    line_number += new_lines;
+    column_number = end - last_new_line - 1;
+  } else {
+    column_number += end - begin;
+  }
+  synced_offset = offset;
+}
+
+void LexerScopeBase::LexingConstructs::EndChunk(Offset token_start,
+                                                Offset chunk_end) {
+  chunk = nullptr;
+  chunk_offset = chunk_end;
+  position_chunk_end = chunk_end;
+  position_token_start = token_start;
+  ReleaseChunk();
+}
+
+void LexerScopeBase::LexingConstructs::ReleaseChunk() {
+  if (position_chunk == nullptr) {
+    return;
+  }
+  SyncPosition(position_token_start);
+  Offset begin_offset = std::max(synced_offset, position_chunk_offset);
+  const char* begin = position_chunk + (begin_offset - position_chunk_offset);
+  const char* end = position_chunk + (position_chunk_end -
+                                      position_chunk_offset);
+  const char* last_new_line = nullptr;
+  uint32_t new_lines = CountNewLines(begin, end, &last_new_line);
+  if (new_lines > 0) {
+    pending_lines += new_lines;
+    pending_column = end - last_new_line - 1;
+  } else {
+    pending_column += end - begin;
+  }
+  position_chunk = nullptr;
+  position_chunk_offset = position_chunk_end;
+}
+
+void LexerScopeBase::LexingConstructs::ResetPosition() {
+  line_number = 1;
+  column_number = 0;
+  synced_offset = 0;
+  pending_lines = 0;
+  pending_column = 0;
+  chunk = nullptr;
+  chunk_offset = 0;
+  position_chunk = nullptr;
+  position_chunk_offset = 0;
+  position_chunk_end = 0;
+  position_token_start = 0;
+}
+
+constexpr int64_t Lexer::kMaxSectionIdRange;
+
 bool Lexer::Finalize() {
   APARSE_ASSERT(machine.initialized);
-  APARSE_ASSERT(section_to_start_state_mapping.size() > 0);
-  APARSE_ASSERT(qk::ContainsKey(section_to_start_state_mapping, main_section));
-  APARSE_ASSERT(pattern_actions.size() > 0);
+  APARSE_ASSERT(machine.dfa.alphabet_class.size() ==
+                LexerMachine::DFA::kAlphabetSize);
+  APARSE_ASSERT(machine.dfa.transition_table.size() ==
+                machine.dfa.states.size() * machine.dfa.num_alphabet_classes);
+  APARSE_ASSERT(machine.dfa.num_exit_bytes.size() ==
+                machine.dfa.states.size());
+  APARSE_ASSERT(machine.dfa.is_terminal_state.size() ==
+                machine.dfa.states.size());
+  APARSE_ASSERT(sections.size() > 0);
+  APARSE_ASSERT(std::is_sorted(sections.begin(), sections.end()));
+  APARSE_ASSERT(section_start_states.size() == sections.size());
+  APARSE_ASSERT(actions.size() > 1);
+  APARSE_ASSERT(label_to_rule.size() == actions.size());
+  APARSE_ASSERT(token_ids.size() == actions.size());
+  APARSE_ASSERT(skip_tokens.size() == actions.size());
+  APARSE_ASSERT(jump_to_sections.size() == actions.size());
+  APARSE_ASSERT(keyword_tables.empty() ||
+                keyword_tables.size() == actions.size());
+  int64_t section_id_range = int64_t(sections.back()) - sections.front() + 1;
+  APARSE_ASSERT(section_id_range <= kMaxSectionIdRange,
+                "Lexer section ids are too sparse");
+  min_section_id = sections.front();
+  section_indexes.assign(section_id_range, -1);
+  for (int i = 0; i < sections.size(); i++) {
+    section_indexes[sections[i] - min_section_id] = i;
+  }
+  main_section_index = SectionIndex(main_section);
+  has_action.resize(actions.size());
+  for (int label = 0; label < actions.size(); label++) {
+    has_action[label] = actions[label].has_value();
+  }
+  for (int32_t section : jump_to_sections) {
+    APARSE_ASSERT(section < static_cast<int32_t>(sections.size()));
+  }
   initialized = true;
   return true;
 }
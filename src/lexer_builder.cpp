@@ -3,10 +3,47 @@
 
 #include "aparse/lexer_builder.hpp"
 
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "src/helpers.hpp"
 #include "src/internal_lexer_builder.hpp"
 #include "src/parse_char_regex.hpp"
 
 namespace aparse {
+namespace helpers {
+
+uint64_t LexerRulesToGrammarHash(const LexerGrammar& grammar) {
+  vector<int> sections;
+  for (auto& section : grammar.rules) {
+    sections.push_back(section.first);
+  }
+  std::sort(sections.begin(), sections.end());
+  std::ostringstream oss;
+  oss << std::hex << std::setfill('0') << std::setw(4);
+  oss << sections.size();
+  for (int section : sections) {
+    auto& rules = grammar.rules.at(section);
+    oss << ":" << section << ":" << rules.size();
+    for (auto& rule : rules) {
+      oss << ":" << rule.regex_string.size() << ":" << rule.regex_string
+          << ":" << rule.token_id << ":" << rule.skip << ":"
+          << rule.has_jump_to << ":" << rule.jump_to << ":"
+          << rule.keywords.size();
+      for (auto& keyword : rule.keywords) {
+        oss << ":" << keyword.regex_string.size() << ":"
+            << keyword.regex_string << ":" << keyword.token_id << ":"
+            << keyword.skip << ":" << keyword.has_jump_to << ":"
+            << keyword.jump_to;
+      }
+    }
+  }
+  oss << ":" << grammar.main_section;
+  return SimpleChecksum(oss.str());
+}
+
+}  // namespace helpers
 
 bool LexerBuilder::Build(const LexerGrammar& lexer_grammar, Lexer* lexer) {
   InternalLexerGrammar igrammar;
@@ -23,11 +60,69 @@ bool LexerBuilder::Build(const LexerGrammar& lexer_grammar, Lexer* lexer) {
         throw error();
       }
       igrammar.rules[section.first].emplace_back(
-                                            Rule(regex).Action(rule.action));
+                                          Rule(regex).Action(rule.action)
+                                                     .Token(rule.token_id)
+                                                     .Skip(rule.skip));
+      if (rule.has_jump_to) {
+        igrammar.rules[section.first].back().JumpTo(rule.jump_to);
+      }
+    }
+    // Keyword rules are placed after all the rules of the section.
+    for (int i = 0; i < section.second.size(); i++) {
+      for (auto& keyword : section.second[i].keywords) {
+        igrammar.rules[section.first].emplace_back(
+            Rule(Regex()).Action(keyword.action)
+                         .Token(keyword.token_id)
+                         .Skip(keyword.skip)
+                         .Keyword(keyword.regex_string, i));
+        if (keyword.has_jump_to) {
+          igrammar.rules[section.first].back().JumpTo(keyword.jump_to);
+        }
+      }
     }
   }
   igrammar.main_section = lexer_grammar.main_section;
   return InternalLexerBuilder::Build(igrammar, lexer);
 }
 
+bool LexerBuilder::Import(const string& serialized_lexer,
+                          const LexerGrammar& lexer_grammar,
+                          Lexer* lexer) {
+  if (lexer->IsInitialized()) {
+    return true;
+  }
+  unordered_map<int, vector<utils::any>> rule_actions;
+  for (auto& section : lexer_grammar.rules) {
+    auto& actions = rule_actions[section.first];
+    for (auto& rule : section.second) {
+      actions.push_back(rule.action);
+    }
+    for (auto& rule : section.second) {
+      for (auto& keyword : rule.keywords) {
+        actions.push_back(keyword.action);
+      }
+    }
+  }
+  return InternalLexerBuilder::Import(
+                        serialized_lexer,
+                        helpers::LexerRulesToGrammarHash(lexer_grammar),
+                        rule_actions,
+                        lexer);
+}
+
+std::string LexerBuilder::Export(const Lexer& lexer,
+                                 const LexerGrammar& lexer_grammar) {
+  string output;
+  Export(lexer, lexer_grammar, &output);
+  return output;
+}
+
+void LexerBuilder::Export(const Lexer& lexer,
+                          const LexerGrammar& lexer_grammar,
+                          std::string* serialized_lexer) {
+  InternalLexerBuilder::Export(lexer,
+                               helpers::LexerRulesToGrammarHash(lexer_grammar),
+                               serialized_lexer);
+}
+
 }  // namespace aparse
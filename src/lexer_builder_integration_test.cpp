@@ -6,6 +6,7 @@
 #include <iostream>
 
 #include <memory>
+#include <string>
 #include "quick/debug.hpp"
 #include "gtest/gtest.h"
 #include "quick/stl_utils.hpp"
@@ -15,6 +16,7 @@ using aparse::Lexer;
 using aparse::LexerInstance;
 using aparse::LexerGrammar;
 using std::vector;
+using std::string;
 using std::cout;
 using std::endl;
 using std::unique_ptr;
@@ -71,3 +73,483 @@ TEST(AdvanceLexerIntegrationTest, Basic) {
                                  PLUS, NUMBER, CLOSE_B1, PLUS, NUMBER}));
   }
 }
+
+
+TEST(AdvanceLexerIntegrationTest, ExportImport) {
+  aparse::Lexer lexer_main;
+  aparse::LexerBuilder::Build(LexerRules1(), &lexer_main);
+  std::string serialized_lexer = aparse::LexerBuilder::Export(lexer_main,
+                                                              LexerRules1());
+  aparse::Lexer imported_lexer;
+  EXPECT_TRUE(aparse::LexerBuilder::Import(serialized_lexer,
+                                           LexerRules1(),
+                                           &imported_lexer));
+  EXPECT_TRUE(imported_lexer.IsInitialized());
+  EXPECT_EQ(lexer_main.machine.dfa.transition_table,
+            imported_lexer.machine.dfa.transition_table);
+  LexerScope1 scope;
+  auto lexer = imported_lexer.CreateInstance(&scope);
+  lexer.FeedOrDie("44+(+(55+66)+29");
+  lexer.EndOrDie();
+  EXPECT_EQ(scope.tokens,
+            (vector<TokenType>{NUMBER, PLUS, OPEN_B1, PLUS, OPEN_B1, NUMBER,
+                               PLUS, NUMBER, CLOSE_B1, PLUS, NUMBER}));
+
+  // Import must fail if the rules are changed.
+  auto lexer_rules = LexerRules1();
+  lexer_rules.rules[0][0].regex_string = "[0-9]*";
+  aparse::Lexer lexer2;
+  EXPECT_FALSE(aparse::LexerBuilder::Import(serialized_lexer,
+                                            lexer_rules,
+                                            &lexer2));
+  EXPECT_FALSE(lexer2.IsInitialized());
+  EXPECT_FALSE(aparse::LexerBuilder::Import("", LexerRules1(), &lexer2));
+}
+
+
+struct AddToken {
+  AddToken() = default;
+  explicit AddToken(TokenType token): token(token) {}
+  void operator()(LexerScope1* scope) const {
+    scope->tokens.push_back(token);
+  }
+  TokenType token;
+};
+
+TEST(AdvanceLexerIntegrationTest, TypedLexer) {
+  aparse::TypedLexerGrammar<LexerScope1, AddToken> lexer_rules;
+  using Rule = decltype(lexer_rules)::Rule;
+  lexer_rules.rules = {
+    {0, {
+      Rule("[0-9]+", AddToken(NUMBER)),
+      Rule("\\(", AddToken(OPEN_B1)),
+      Rule("\\)", AddToken(CLOSE_B1)),
+      Rule("\\+", AddToken(PLUS)),
+      Rule(" |\t|\n", AddToken(WHITESPACE)),
+    }}
+  };
+  aparse::TypedLexer<LexerScope1, AddToken> typed_lexer;
+  EXPECT_TRUE(aparse::LexerBuilder::Build(lexer_rules, &typed_lexer));
+  LexerScope1 scope;
+  auto lexer = typed_lexer.CreateInstance(&scope);
+  lexer.FeedOrDie("44+(+(55+66)+ 29");
+  lexer.EndOrDie();
+  EXPECT_EQ(scope.tokens,
+            (vector<TokenType>{NUMBER, PLUS, OPEN_B1, PLUS, OPEN_B1, NUMBER,
+                               PLUS, NUMBER, CLOSE_B1, PLUS, WHITESPACE,
+                               NUMBER}));
+
+  auto serialized_lexer = aparse::LexerBuilder::Export(
+                              typed_lexer.lexer,
+                              lexer_rules.ToLexerGrammar());
+  aparse::TypedLexer<LexerScope1, AddToken> imported_lexer;
+  EXPECT_TRUE(aparse::LexerBuilder::Import(serialized_lexer,
+                                           lexer_rules,
+                                           &imported_lexer));
+  scope.tokens.clear();
+  auto lexer2 = imported_lexer.CreateInstance(&scope);
+  lexer2.FeedOrDie("(7)");
+  lexer2.EndOrDie();
+  EXPECT_EQ(scope.tokens, (vector<TokenType>{OPEN_B1, NUMBER, CLOSE_B1}));
+}
+
+TEST(AdvanceLexerIntegrationTest, TypedLexerWithFunctionPointers) {
+  aparse::TypedLexerGrammar<LexerScope1> lexer_rules;
+  using Rule = decltype(lexer_rules)::Rule;
+  lexer_rules.rules = {
+    {0, {
+      Rule("[0-9]+", [](LexerScope1* s) { s->tokens.push_back(NUMBER); }),
+      Rule("\\+", [](LexerScope1* s) { s->tokens.push_back(PLUS); }),
+    }}
+  };
+  aparse::TypedLexer<LexerScope1> typed_lexer;
+  EXPECT_TRUE(aparse::LexerBuilder::Build(lexer_rules, &typed_lexer));
+  LexerScope1 scope;
+  auto lexer = typed_lexer.CreateInstance(&scope);
+  lexer.FeedOrDie("1+22+333");
+  lexer.EndOrDie();
+  EXPECT_EQ(scope.tokens,
+            (vector<TokenType>{NUMBER, PLUS, NUMBER, PLUS, NUMBER}));
+}
+
+
+TEST(AdvanceLexerIntegrationTest, TokenBuffer) {
+  using Rule = aparse::LexerGrammar::Rule;
+  aparse::LexerGrammar lexer_rules;
+  lexer_rules.rules = {
+    {0, {
+      Rule("[0-9]+").Token(NUMBER),
+      Rule("\\(").Token(OPEN_B1),
+      Rule("\\)").Token(CLOSE_B1),
+      Rule("\\+").Token(PLUS),
+      Rule("( |\t|\n)+").Skip(),
+    }}
+  };
+  aparse::Lexer lexer_main;
+  aparse::LexerBuilder::Build(lexer_rules, &lexer_main);
+  aparse::LexerScopeBase scope;
+  aparse::TokenBuffer token_buffer(100);
+  auto lexer = lexer_main.CreateInstance(&scope, &token_buffer);
+  lexer.FeedOrDie("44 + (55  +\n66)");
+  lexer.EndOrDie();
+  EXPECT_EQ(token_buffer.Alphabets(),
+            (vector<aparse::Alphabet>{NUMBER, PLUS, OPEN_B1, NUMBER, PLUS,
+                                      NUMBER, CLOSE_B1}));
+  EXPECT_EQ(7, token_buffer.size());
+  EXPECT_EQ(0, token_buffer.starts()[0]);
+  EXPECT_EQ(2, token_buffer.ends()[0]);
+  EXPECT_EQ(12, token_buffer.starts()[5]);
+  EXPECT_EQ(14, token_buffer.ends()[5]);
+
+  // Caller provided memory of 2 tokens: Feed fails once it's full and is
+  // resumed after draining the buffer.
+  aparse::Alphabet token_ids[2];
+  aparse::Offset starts[2], ends[2];
+  token_buffer.Attach(token_ids, starts, ends, 2);
+  lexer.Reset();
+  std::string input = "1+2+3";
+  vector<aparse::Alphabet> output;
+  size_t offset = 0;
+  aparse::Error error;
+  while (not lexer.Feed(input.data() + offset, input.size() - offset,
+                        &error)) {
+    EXPECT_EQ(aparse::Error::LEXER_ERROR_TOKEN_BUFFER_FULL, error.status);
+    EXPECT_TRUE(token_buffer.full());
+    output.insert(output.end(), token_ids, token_ids + token_buffer.size());
+    token_buffer.Clear();
+    offset = lexer.token_end;
+  }
+  EXPECT_FALSE(lexer.End(&error));
+  EXPECT_EQ(aparse::Error::LEXER_ERROR_TOKEN_BUFFER_FULL, error.status);
+  output.insert(output.end(), token_ids, token_ids + token_buffer.size());
+  token_buffer.Clear();
+  EXPECT_TRUE(lexer.End());
+  output.insert(output.end(), token_ids, token_ids + token_buffer.size());
+  EXPECT_EQ(output, (vector<aparse::Alphabet>{NUMBER, PLUS, NUMBER, PLUS,
+                                              NUMBER}));
+  EXPECT_EQ(4, starts[0]);
+  EXPECT_EQ(5, ends[0]);
+}
+
+
+TEST(AdvanceLexerIntegrationTest, LongCommentsAndStrings) {
+  using Rule = aparse::LexerGrammar::Rule;
+  aparse::LexerGrammar lexer_rules;
+  lexer_rules.rules = {
+    {0, {
+      Rule("[0-9]+").Token(NUMBER),
+      Rule("\"[^\"]*\"").Token(OPEN_B1),
+      Rule("//[^\n]*").Token(CLOSE_B1),
+      Rule("( |\t|\n)+").Skip(),
+    }}
+  };
+  aparse::Lexer lexer_main;
+  aparse::LexerBuilder::Build(lexer_rules, &lexer_main);
+  std::string input;
+  for (int i = 0; i < 50; i++) {
+    input += "// " + std::string(i * 7, 'c') + " \"55\" //\n";
+    input += "\"" + std::string(i * 5, 's') + "// 7\n\"" + std::to_string(i);
+    input += "\n";
+  }
+  aparse::LexerScopeBase scope;
+  aparse::TokenBuffer expected(input.size());
+  auto lexer1 = lexer_main.CreateInstance(&scope, &expected);
+  for (char c : input) {
+    EXPECT_TRUE(lexer1.Feed(static_cast<unsigned char>(c)));
+  }
+  EXPECT_TRUE(lexer1.End());
+  EXPECT_EQ(150, expected.size());
+  aparse::TokenBuffer output(input.size());
+  auto lexer2 = lexer_main.CreateInstance(&scope, &output);
+  lexer2.FeedOrDie(input);
+  lexer2.EndOrDie();
+  EXPECT_EQ(expected.Alphabets(), output.Alphabets());
+  EXPECT_EQ(vector<aparse::Offset>(expected.ends(),
+                                   expected.ends() + expected.size()),
+            vector<aparse::Offset>(output.ends(),
+                                   output.ends() + output.size()));
+}
+
+
+TEST(AdvanceLexerIntegrationTest, ManySections) {
+  using Rule = aparse::LexerGrammar::Rule;
+  aparse::LexerGrammar lexer_rules;
+  const int num_sections = 9;
+  for (int section = 0; section < num_sections; section++) {
+    auto lJumpTo = [section](aparse::LexerScopeBase* scope) {
+      scope->JumpTo((section + 1) % num_sections);
+    };
+    lexer_rules.rules[section] = {
+      Rule("[0-9]+").Action(lJumpTo),
+      Rule("[a-z]+" + std::to_string(section)).Action(lJumpTo),
+      Rule("( |\t|\n)+"),
+    };
+  }
+  aparse::Lexer lexer_main;
+  aparse::LexerBuilder::Build(lexer_rules, &lexer_main);
+  auto& build_stats = lexer_main.machine.build_stats;
+  EXPECT_EQ(num_sections, build_stats.section_dfa_sizes.size());
+  EXPECT_EQ(num_sections, build_stats.section_peak_memory.size());
+  size_t total_memory = 0;
+  for (auto& item : build_stats.section_peak_memory) {
+    EXPECT_LT(0, item.second);
+    total_memory += item.second;
+  }
+  EXPECT_EQ(total_memory, build_stats.peak_memory);
+  EXPECT_LE(0, build_stats.build_time_us);
+  aparse::LexerScopeBase scope;
+  auto lexer = lexer_main.CreateInstance(&scope);
+  lexer.FeedOrDie("abc0 12 xyz2 5 a4 bb5 66 c7 dd8 ab0");
+  lexer.EndOrDie();
+  lexer.Reset();
+  EXPECT_FALSE(lexer.Feed("abc0 12 xyz3"));
+}
+
+
+TEST(AdvanceLexerIntegrationTest, Keywords) {
+  enum {IDENTIFIER = 1, IF, INT, RETURN, SPACE};
+  using Rule = aparse::LexerGrammar::Rule;
+  aparse::LexerGrammar lexer_rules;
+  lexer_rules.rules = {
+    {0, {
+      Rule("[a-zA-Z_][a-zA-Z0-9_]*").Token(IDENTIFIER)
+                                    .Keyword(Rule("if").Token(IF))
+                                    .Keyword(Rule("int").Token(INT))
+                                    .Keyword(Rule("return").Token(RETURN)),
+      Rule("( |\n)+").Token(SPACE),
+    }}
+  };
+  aparse::Lexer lexer_main;
+  aparse::LexerBuilder::Build(lexer_rules, &lexer_main);
+  string input = "if iff int in returns return _if\nreturn";
+  vector<aparse::Alphabet> expected = {IF, SPACE, IDENTIFIER, SPACE, INT,
+                                       SPACE, IDENTIFIER, SPACE, IDENTIFIER,
+                                       SPACE, RETURN, SPACE, IDENTIFIER,
+                                       SPACE, RETURN};
+  aparse::LexerScopeBase scope;
+  {
+    aparse::TokenBuffer output(100);
+    auto lexer = lexer_main.CreateInstance(&scope, &output);
+    lexer.FeedOrDie(input);
+    lexer.EndOrDie();
+    EXPECT_EQ(expected, output.Alphabets());
+  }
+  // Keywords straddling the chunks.
+  for (int chunk_size : {1, 2, 3, 5}) {
+    aparse::TokenBuffer output(100);
+    auto lexer = lexer_main.CreateInstance(&scope, &output);
+    for (int i = 0; i < input.size(); i += chunk_size) {
+      lexer.FeedOrDie(input.substr(i, chunk_size));
+    }
+    lexer.EndOrDie();
+    EXPECT_EQ(expected, output.Alphabets());
+  }
+  // Resuming after the token buffer got full.
+  {
+    aparse::TokenBuffer output(1);
+    auto lexer = lexer_main.CreateInstance(&scope, &output);
+    vector<aparse::Alphabet> tokens;
+    int offset = 0;
+    for (int i = 0; i < 100 && offset < input.size(); i++) {
+      aparse::Error error;
+      if (not lexer.Feed(input.substr(offset, 4), &error)) {
+        EXPECT_EQ(aparse::Error::LEXER_ERROR_TOKEN_BUFFER_FULL, error.status);
+      }
+      offset = lexer.token_end;
+      if (output.size() > 0) {
+        tokens.push_back(output.token_ids()[0]);
+        output.Clear();
+      }
+    }
+    EXPECT_TRUE(lexer.End());
+    tokens.push_back(output.token_ids()[0]);
+    EXPECT_EQ(expected, tokens);
+  }
+  // Actions of the keywords.
+  {
+    auto lexer_rules2 = lexer_rules;
+    vector<string> keywords;
+    lexer_rules2.rules[0][0].keywords[2].Action(
+        [&](aparse::LexerScopeBase* scope) {
+          keywords.push_back("return");
+        });
+    aparse::Lexer lexer2;
+    aparse::LexerBuilder::Build(lexer_rules2, &lexer2);
+    auto lexer = lexer2.CreateInstance(&scope);
+    lexer.FeedOrDie(input);
+    lexer.EndOrDie();
+    EXPECT_EQ((vector<string>{"return", "return"}), keywords);
+  }
+  // Export / Import.
+  {
+    string serialized = aparse::LexerBuilder::Export(lexer_main, lexer_rules);
+    aparse::Lexer imported_lexer;
+    EXPECT_TRUE(aparse::LexerBuilder::Import(serialized, lexer_rules,
+                                             &imported_lexer));
+    aparse::TokenBuffer output(100);
+    auto lexer = imported_lexer.CreateInstance(&scope, &output);
+    lexer.FeedOrDie(input);
+    lexer.EndOrDie();
+    EXPECT_EQ(expected, output.Alphabets());
+    auto lexer_rules2 = lexer_rules;
+    lexer_rules2.rules[0][0].keywords[0].regex_string = "iff";
+    aparse::Lexer lexer2;
+    EXPECT_FALSE(aparse::LexerBuilder::Import(serialized, lexer_rules2,
+                                              &lexer2));
+    // Rules differing only in the jump target of a keyword.
+    auto lexer_rules3 = lexer_rules;
+    lexer_rules3.rules[0][0].keywords[0].JumpTo(0);
+    EXPECT_NE(serialized,
+              aparse::LexerBuilder::Export(lexer_main, lexer_rules3));
+    EXPECT_FALSE(aparse::LexerBuilder::Import(serialized, lexer_rules3,
+                                              &lexer2));
+    auto lexer_rules4 = lexer_rules3;
+    lexer_rules4.rules[0][0].keywords[0].jump_to = 1;
+    EXPECT_NE(aparse::LexerBuilder::Export(lexer_main, lexer_rules3),
+              aparse::LexerBuilder::Export(lexer_main, lexer_rules4));
+  }
+  // A keyword must be a lexeme of its rule.
+  for (string keyword : {"if", "9x", ""}) {
+    auto lexer_rules2 = lexer_rules;
+    lexer_rules2.rules[0][0].Keyword(Rule(keyword));
+    aparse::Lexer lexer2;
+    try {
+      aparse::LexerBuilder::Build(lexer_rules2, &lexer2);
+      EXPECT_TRUE(false);
+    } catch (const aparse::Error& error) {
+      EXPECT_EQ(aparse::Error::LEXER_BUILDER_ERROR_INVALID_KEYWORD,
+                error.status);
+    }
+  }
+}
+
+
+TEST(AdvanceLexerIntegrationTest, RuleJumpTo) {
+  enum {NUMBER = 1, QUOTE, STRING_BODY, SPACE};
+  const int kCode = 10, kString = -20;
+  using Rule = aparse::LexerGrammar::Rule;
+  aparse::LexerGrammar lexer_rules;
+  lexer_rules.main_section = kCode;
+  lexer_rules.rules = {
+    {kCode, {
+      Rule("[0-9]+").Token(NUMBER),
+      Rule("\"").Token(QUOTE).JumpTo(kString),
+      Rule(" +").Token(SPACE),
+    }},
+    {kString, {
+      Rule("[^\"]+").Token(STRING_BODY),
+      Rule("\"").Token(QUOTE).JumpTo(kCode),
+    }}
+  };
+  aparse::Lexer lexer_main;
+  aparse::LexerBuilder::Build(lexer_rules, &lexer_main);
+  EXPECT_EQ((vector<int>{kString, kCode}), lexer_main.sections);
+  string input = "12 \"34 \" 56\"\"";
+  vector<aparse::Alphabet> expected = {NUMBER, SPACE, QUOTE, STRING_BODY,
+                                       QUOTE, SPACE, NUMBER, QUOTE, QUOTE};
+  aparse::LexerScopeBase scope;
+  aparse::TokenBuffer output(100);
+  auto lexer = lexer_main.CreateInstance(&scope, &output);
+  lexer.FeedOrDie(input);
+  lexer.EndOrDie();
+  EXPECT_EQ(expected, output.Alphabets());
+
+  // Actions are invoked after the switch, and can override it.
+  struct Scope : aparse::LexerScopeBase {
+    vector<string> tokens;
+  };
+  aparse::LexerGrammar lexer_rules2 = lexer_rules;
+  lexer_rules2.rules[kCode][0].Action([](Scope* scope) {
+    scope->JumpTo(kString);
+  });
+  lexer_rules2.rules[kString][0].Action([](Scope* scope) {
+    scope->tokens.push_back("body");
+  });
+  aparse::Lexer lexer2;
+  aparse::LexerBuilder::Build(lexer_rules2, &lexer2);
+  Scope scope2;
+  auto lexer_instance2 = lexer2.CreateInstance(&scope2);
+  lexer_instance2.FeedOrDie("12abc\"45\"\"x y\"");
+  lexer_instance2.EndOrDie();
+  EXPECT_EQ((vector<string>{"body", "body"}), scope2.tokens);
+
+  lexer_rules2.rules[kCode][1].JumpTo(30);
+  aparse::Lexer lexer3;
+  try {
+    aparse::LexerBuilder::Build(lexer_rules2, &lexer3);
+    EXPECT_TRUE(false);
+  } catch (const aparse::Error& error) {
+    EXPECT_EQ(aparse::Error::LEXER_BUILDER_ERROR_INVALID_SECTION, error.status);
+  }
+}
+
+
+TEST(AdvanceLexerIntegrationTest, TokenText) {
+  struct Scope : aparse::LexerScopeBase {
+    vector<string> texts;
+    vector<aparse::utils::string_view> views;
+  };
+  using Rule = aparse::LexerGrammar::Rule;
+  aparse::LexerGrammar lexer_rules;
+  auto lAddText = [](Scope* scope) {
+    scope->texts.push_back(scope->Text().to_string());
+    scope->views.push_back(scope->Text());
+  };
+  lexer_rules.rules = {
+    {0, {
+      Rule("[0-9]+").Action(lAddText),
+      Rule("\"[^\"]*\"").Action(lAddText),
+      Rule(" +").Action(lAddText),
+    }}
+  };
+  aparse::Lexer lexer_main;
+  aparse::LexerBuilder::Build(lexer_rules, &lexer_main);
+  string input = "12 \"a long string\" 345  6 \"\"";
+  vector<string> expected = {"12", " ", "\"a long string\"", " ", "345", "  ",
+                             "6", " ", "\"\""};
+  {
+    Scope scope;
+    auto lexer = lexer_main.CreateInstance(&scope);
+    lexer.FeedOrDie(input);
+    lexer.EndOrDie();
+    EXPECT_EQ(expected, scope.texts);
+    // Except the last one, the texts are views into the input.
+    for (int i = 0; i + 1 < scope.views.size(); i++) {
+      EXPECT_GE(scope.views[i].data(), input.data());
+      EXPECT_LE(scope.views[i].end(), input.data() + input.size());
+    }
+  }
+  for (int chunk_size : {1, 2, 7}) {
+    Scope scope;
+    auto lexer = lexer_main.CreateInstance(&scope);
+    for (int i = 0; i < input.size(); i += chunk_size) {
+      lexer.FeedOrDie(input.substr(i, chunk_size));
+    }
+    lexer.EndOrDie();
+    EXPECT_EQ(expected, scope.texts);
+  }
+}
+
+
+TEST(AdvanceLexerIntegrationTest, EagerEmission) {
+  aparse::Lexer lexer_main;
+  aparse::LexerBuilder::Build(LexerRules1(), &lexer_main);
+  LexerScope1 scope;
+  auto lexer = lexer_main.CreateInstance(&scope);
+  // The tokens which can't be extended are emitted without waiting for the
+  // next byte.
+  lexer.FeedOrDie("44+(");
+  EXPECT_EQ((vector<TokenType>{NUMBER, PLUS, OPEN_B1}), scope.tokens);
+  lexer.FeedOrDie("55");
+  EXPECT_EQ((vector<TokenType>{NUMBER, PLUS, OPEN_B1}), scope.tokens);
+  lexer.FeedOrDie(")");
+  EXPECT_EQ((vector<TokenType>{NUMBER, PLUS, OPEN_B1, NUMBER, CLOSE_B1}),
+            scope.tokens);
+  EXPECT_EQ(6, scope.Range().first);
+  EXPECT_EQ(7, scope.Range().second);
+  lexer.EndOrDie();
+  EXPECT_EQ(5, scope.tokens.size());
+  // Nothing is fed after the reset.
+  lexer.Reset();
+  EXPECT_FALSE(lexer.End());
+}
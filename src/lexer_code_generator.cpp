@@ -0,0 +1,151 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/lexer_code_generator.hpp"
+
+#include <cctype>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace aparse {
+
+namespace {
+
+// Writes the declaration `static constexpr @type @name[] = {...};` of a
+// member of the LexerTables, wrapping the values at 80 columns, and appends
+// its (namespace scope) definition to @definitions.
+template<typename T>
+void WriteArray(const std::string& type,
+                const std::string& name,
+                const std::vector<T>& values,
+                std::ostringstream* oss,
+                std::ostringstream* definitions) {
+  *oss << "  static constexpr " << type << " " << name << "[] = {\n";
+  std::string line = "     ";
+  for (size_t i = 0; i < values.size(); i++) {
+    std::string item = " " + std::to_string(values[i]) + ",";
+    if (line.size() + item.size() > 80) {
+      *oss << line << "\n";
+      line = "     ";
+    }
+    line += item;
+  }
+  *oss << line << "\n  };\n";
+  *definitions << "template<typename Unused>\n"
+               << "constexpr " << type << " LexerTables<Unused>::" << name
+               << "[];\n";
+}
+
+}  // namespace
+
+// static
+std::string LexerCodeGenerator::Generate(const Lexer& lexer,
+                                         const std::string& namespace_name) {
+  APARSE_ASSERT(lexer.IsInitialized());
+  APARSE_ASSERT(lexer.keyword_tables.empty(),
+                "Keywords are not supported in the generated lexers yet");
+  for (int32_t section : lexer.jump_to_sections) {
+    APARSE_ASSERT(section < 0 || section == lexer.main_section_index,
+                  "Generated lexers support the main section only");
+  }
+  const auto& dfa = lexer.machine.dfa;
+  int num_states = dfa.states.size();
+  std::vector<int> is_final(num_states), is_skip(num_states),
+                   token_ids(num_states);
+  for (int i = 0; i < num_states; i++) {
+    int label = dfa.states[i].label;
+    is_final[i] = dfa.IsFinal(i);
+    is_skip[i] = lexer.skip_tokens.at(label);
+    token_ids[i] = lexer.token_ids.at(label);
+  }
+  std::string state_type = (num_states < (1 << 15)) ? "int16_t" : "int32_t";
+  std::string guard = "APARSE_GENERATED_LEXER_";
+  for (char c : namespace_name) {
+    guard += std::isalnum(c) ? std::toupper(c) : '_';
+  }
+  guard += "_HPP_";
+  std::ostringstream oss;
+  oss << "// Generated by aparse::LexerCodeGenerator. Do not edit.\n\n"
+      << "#ifndef " << guard << "\n"
+      << "#define " << guard << "\n\n"
+      << "#include <cstddef>\n"
+      << "#include <cstdint>\n\n"
+      << "namespace " << namespace_name << " {\n\n"
+      << "// The tables are static members of a class template, so that they "
+         "have a\n// single definition across the translation units "
+         "including this header.\n"
+      << "template<typename Unused = void>\n"
+      << "struct LexerTables {\n"
+      << "  static constexpr int32_t kNumAlphabetClasses = "
+      << dfa.num_alphabet_classes << ";\n"
+      << "  static constexpr int32_t kStartState = "
+      << lexer.section_start_states[lexer.main_section_index] << ";\n";
+  std::ostringstream definitions;
+  definitions << "template<typename Unused>\n"
+              << "constexpr int32_t LexerTables<Unused>::kNumAlphabetClasses;"
+              << "\n"
+              << "template<typename Unused>\n"
+              << "constexpr int32_t LexerTables<Unused>::kStartState;\n";
+  WriteArray("uint8_t", "kAlphabetClass", dfa.alphabet_class, &oss,
+             &definitions);
+  oss << "  // kTransitionTable[s * kNumAlphabetClasses + c] = target of the "
+         "state s on\n  // the bytes of class c, or -1.\n";
+  WriteArray(state_type, "kTransitionTable", dfa.transition_table, &oss,
+             &definitions);
+  WriteArray("uint8_t", "kIsFinal", is_final, &oss, &definitions);
+  WriteArray("uint8_t", "kIsSkip", is_skip, &oss, &definitions);
+  WriteArray("int32_t", "kTokenId", token_ids, &oss, &definitions);
+  oss << "};\n\n" << definitions.str() << "\n";
+  oss << R"(/** Lex [data, data+len). sink(token_id, start, end) is called for
+ *  every token, except for the tokens of the skip rules.
+ *  @returns false in case of invalid or incomplete tokens. */
+template<typename Sink>
+inline bool Lex(const char* data, size_t len, Sink& sink) {
+  using T = LexerTables<>;
+  size_t token_start = 0;
+  int32_t state = T::kStartState;
+  for (size_t i = 0; i < len; i++) {
+    int32_t c = T::kAlphabetClass[static_cast<uint8_t>(data[i])];
+    int32_t next_state = T::kTransitionTable[state * T::kNumAlphabetClasses
+                                             + c];
+    if (next_state < 0) {
+      if (not T::kIsFinal[state]) {
+        return false;
+      }
+      if (not T::kIsSkip[state]) {
+        sink(T::kTokenId[state], token_start, i);
+      }
+      token_start = i;
+      state = T::kStartState;
+      next_state = T::kTransitionTable[state * T::kNumAlphabetClasses + c];
+      if (next_state < 0) {
+        return false;
+      }
+    }
+    state = next_state;
+  }
+  if (not T::kIsFinal[state]) {
+    return false;
+  }
+  if (not T::kIsSkip[state]) {
+    sink(T::kTokenId[state], token_start, len);
+  }
+  return true;
+}
+
+)";
+  oss << "}  // namespace " << namespace_name << "\n\n"
+      << "#endif  // " << guard << "\n";
+  return oss.str();
+}
+
+// static
+std::string LexerCodeGenerator::Generate(const LexerGrammar& lexer_grammar,
+                                         const std::string& namespace_name) {
+  Lexer lexer;
+  LexerBuilder::Build(lexer_grammar, &lexer);
+  return Generate(lexer, namespace_name);
+}
+
+}  // namespace aparse
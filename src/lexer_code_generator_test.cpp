@@ -0,0 +1,113 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/lexer_code_generator.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tests/samples/generated_calc_lexer.hpp"
+
+using aparse::LexerGrammar;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Same as the tests/samples/calc_lexer_rules.txt.
+LexerGrammar CalcLexerRules() {
+  using Rule = LexerGrammar::Rule;
+  LexerGrammar lexer_rules;
+  lexer_rules.rules = {
+    {0, {
+      Rule("[0-9]+").Token(1),
+      Rule("[a-z_][a-z_0-9]*").Token(2),
+      Rule("\\+").Token(3),
+      Rule("\\*").Token(4),
+      Rule("\\(").Token(5),
+      Rule("\\)").Token(6),
+      Rule("[ \t\n]+").Skip(),
+    }}
+  };
+  return lexer_rules;
+}
+
+using Tokens = vector<std::tuple<aparse::Alphabet, size_t, size_t>>;
+
+}  // namespace
+
+TEST(LexerCodeGeneratorTest, Basic) {
+  using Rule = LexerGrammar::Rule;
+  LexerGrammar lexer_rules;
+  lexer_rules.rules = {
+    {0, {
+      Rule("[0-9]+").Token(1),
+      Rule("\\+").Token(2),
+      Rule(" +").Skip(),
+    }}
+  };
+  aparse::Lexer lexer;
+  aparse::LexerBuilder::Build(lexer_rules, &lexer);
+  string code = aparse::LexerCodeGenerator::Generate(lexer, "calc_lexer");
+  EXPECT_EQ(code, aparse::LexerCodeGenerator::Generate(lexer_rules,
+                                                       "calc_lexer"));
+  EXPECT_NE(string::npos, code.find("#ifndef APARSE_GENERATED_LEXER_CALC_"
+                                    "LEXER_HPP_"));
+  EXPECT_NE(string::npos, code.find("namespace calc_lexer {"));
+  EXPECT_NE(string::npos, code.find("constexpr int32_t kNumAlphabetClasses = "
+                                    + std::to_string(
+                                        lexer.machine.dfa.num_alphabet_classes)
+                                    + ";"));
+  EXPECT_NE(string::npos, code.find("constexpr int16_t kTransitionTable[]"));
+  EXPECT_NE(string::npos,
+            code.find("bool Lex(const char* data, size_t len, Sink& sink)"));
+  for (auto& line : {"#include <cstddef>", "#include <cstdint>"}) {
+    EXPECT_NE(string::npos, code.find(line));
+  }
+  EXPECT_EQ(string::npos, code.find("aparse/"));
+}
+
+// The checked-in generated lexer must be up to date with the generator and
+// must tokenize the same way as the Lexer it is generated from.
+TEST(LexerCodeGeneratorTest, GeneratedCalcLexer) {
+  // The path of the repository root, relative to the working directory if
+  // __FILE__ is relative.
+  string this_file = __FILE__;
+  string root = this_file.substr(
+      0, this_file.size() - string("src/lexer_code_generator_test.cpp").size());
+  std::ifstream golden_file(root + "tests/samples/generated_calc_lexer.hpp");
+  ASSERT_TRUE(golden_file.good());
+  std::stringstream golden;
+  golden << golden_file.rdbuf();
+  aparse::Lexer lexer;
+  aparse::LexerBuilder::Build(CalcLexerRules(), &lexer);
+  EXPECT_EQ(golden.str(),
+            aparse::LexerCodeGenerator::Generate(lexer, "calc_lexer"));
+
+  for (string input : {"", "  ", "x1 + (22*_y)\n* 7", "12ab", "(((a)))",
+                       "a + ?", "4 $ 5", "abc  ", "  9"}) {
+    aparse::LexerScopeBase scope;
+    aparse::TokenBuffer token_buffer(input.size());
+    auto lexer_instance = lexer.CreateInstance(&scope, &token_buffer);
+    aparse::Error error;
+    bool expected_success = lexer_instance.Feed(input, &error) &&
+                            lexer_instance.End(&error);
+    Tokens expected_tokens;
+    for (size_t i = 0; i < token_buffer.size(); i++) {
+      expected_tokens.emplace_back(token_buffer.token_ids()[i],
+                                   token_buffer.starts()[i],
+                                   token_buffer.ends()[i]);
+    }
+    Tokens tokens;
+    auto sink = [&](int32_t token_id, size_t start, size_t end) {
+      tokens.emplace_back(token_id, start, end);
+    };
+    EXPECT_EQ(expected_success,
+              calc_lexer::Lex(input.data(), input.size(), sink)) << input;
+    EXPECT_EQ(expected_tokens, tokens) << input;
+  }
+}
@@ -0,0 +1,108 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/lexer_input.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+
+#include "aparse/utils/assert.hpp"
+
+namespace aparse {
+
+constexpr size_t MmapInputSource::kDefaultWindowSize;
+constexpr size_t FdInputSource::kDefaultChunkSize;
+constexpr size_t IstreamInputSource::kDefaultChunkSize;
+
+MmapInputSource::MmapInputSource(size_t window_size) {
+  // Windows must start at the page boundaries.
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  this->window_size = std::max<size_t>(
+      (window_size + page_size - 1) / page_size * page_size, page_size);
+}
+
+MmapInputSource::~MmapInputSource() {
+  Unmap();
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+bool MmapInputSource::Open(const std::string& path) {
+  APARSE_ASSERT(fd < 0, "MmapInputSource is already opened");
+  fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    failed_ = true;
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    failed_ = true;
+    return false;
+  }
+  file_size = file_stat.st_size;
+  offset = 0;
+  return true;
+}
+
+void MmapInputSource::Unmap() {
+  if (window != nullptr) {
+    munmap(window, window_length);
+    window = nullptr;
+  }
+}
+
+utils::string_view MmapInputSource::ReadChunk() {
+  Unmap();
+  if (fd < 0 || offset >= file_size) {
+    return utils::string_view();
+  }
+  window_length = std::min(window_size, file_size - offset);
+  window = mmap(nullptr, window_length, PROT_READ, MAP_PRIVATE, fd, offset);
+  if (window == MAP_FAILED) {
+    window = nullptr;
+    failed_ = true;
+    return utils::string_view();
+  }
+  madvise(window, window_length, MADV_SEQUENTIAL);
+  offset += window_length;
+  return utils::string_view(static_cast<const char*>(window), window_length);
+}
+
+FdInputSource::FdInputSource(int fd, size_t chunk_size)
+  : fd(fd), buffer(std::max<size_t>(chunk_size, 1)) {}
+
+utils::string_view FdInputSource::ReadChunk() {
+  while (true) {
+    ssize_t n = read(fd, buffer.data(), buffer.size());
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      failed_ = true;
+      n = 0;
+    }
+    return utils::string_view(buffer.data(), n);
+  }
+}
+
+IstreamInputSource::IstreamInputSource(std::istream* input,
+                                       size_t chunk_size)
+  : input(input), buffer(std::max<size_t>(chunk_size, 1)) {}
+
+utils::string_view IstreamInputSource::ReadChunk() {
+  input->read(buffer.data(), buffer.size());
+  size_t n = input->gcount();
+  if (n == 0 && input->bad()) {
+    failed_ = true;
+  }
+  return utils::string_view(buffer.data(), n);
+}
+
+}  // namespace aparse
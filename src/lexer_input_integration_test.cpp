@@ -0,0 +1,163 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/lexer_input.hpp"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "aparse/lexer_builder.hpp"
+#include "gtest/gtest.h"
+
+using aparse::Alphabet;
+using aparse::LexerGrammar;
+using aparse::LexerInputSource;
+using aparse::TokenBuffer;
+using std::string;
+using std::vector;
+
+namespace {
+
+enum {NUMBER = 1, IDENTIFIER, STRING, IF};
+
+LexerGrammar LexerRules() {
+  using Rule = LexerGrammar::Rule;
+  LexerGrammar lexer_rules;
+  lexer_rules.rules = {
+    {0, {
+      Rule("[0-9]+").Token(NUMBER),
+      Rule("[a-z]+").Token(IDENTIFIER).Keyword(Rule("if").Token(IF)),
+      Rule("\"[^\"]*\"").Token(STRING),
+      Rule("( |\n)+").Skip(),
+    }}
+  };
+  return lexer_rules;
+}
+
+string Input() {
+  string output;
+  for (int i = 0; i < 3000; i++) {
+    output += "if " + std::to_string(i * 31) + " iff \"" +
+              string(i % 50, 's') + "\"\n" + string(i % 20, 'x') + "y ";
+  }
+  return output;
+}
+
+struct Tokens {
+  vector<Alphabet> token_ids;
+  vector<aparse::Offset> starts, ends;
+  void Append(const TokenBuffer& token_buffer) {
+    auto ids = token_buffer.Alphabets();
+    token_ids.insert(token_ids.end(), ids.begin(), ids.end());
+    starts.insert(starts.end(), token_buffer.starts(),
+                  token_buffer.starts() + token_buffer.size());
+    ends.insert(ends.end(), token_buffer.ends(),
+                token_buffer.ends() + token_buffer.size());
+  }
+  bool operator==(const Tokens& other) const {
+    return token_ids == other.token_ids && starts == other.starts &&
+           ends == other.ends;
+  }
+};
+
+// Lex the whole @source with a token buffer of @capacity, resuming whenever
+// it gets full.
+Tokens LexSource(const aparse::Lexer& lexer, LexerInputSource* source,
+                 size_t capacity) {
+  Tokens output;
+  aparse::LexerScopeBase scope;
+  TokenBuffer token_buffer(capacity);
+  auto lexer_instance = lexer.CreateInstance(&scope, &token_buffer);
+  aparse::Error error;
+  while (not lexer_instance.Feed(source, &error)) {
+    EXPECT_EQ(aparse::Error::LEXER_ERROR_TOKEN_BUFFER_FULL, error.status);
+    output.Append(token_buffer);
+    token_buffer.Clear();
+  }
+  while (not lexer_instance.End(&error)) {
+    EXPECT_EQ(aparse::Error::LEXER_ERROR_TOKEN_BUFFER_FULL, error.status);
+    output.Append(token_buffer);
+    token_buffer.Clear();
+  }
+  output.Append(token_buffer);
+  return output;
+}
+
+class TempFile {
+ public:
+  explicit TempFile(const string& content) {
+    char name[] = "/tmp/aparse_lexer_input_XXXXXX";
+    int fd = mkstemp(name);
+    EXPECT_LE(0, fd);
+    close(fd);
+    path = name;
+    std::ofstream(path) << content;
+  }
+  ~TempFile() {
+    unlink(path.c_str());
+  }
+  string path;
+};
+
+}  // namespace
+
+TEST(LexerInputIntegrationTest, AllSources) {
+  aparse::Lexer lexer;
+  aparse::LexerBuilder::Build(LexerRules(), &lexer);
+  string input = Input();
+  Tokens expected;
+  {
+    aparse::LexerScopeBase scope;
+    TokenBuffer token_buffer(input.size());
+    auto lexer_instance = lexer.CreateInstance(&scope, &token_buffer);
+    lexer_instance.FeedOrDie(input);
+    lexer_instance.EndOrDie();
+    expected.Append(token_buffer);
+  }
+  TempFile file(input);
+  for (size_t capacity : {size_t(7), input.size()}) {
+    {
+      // Windows of a page, so that the tokens straddle the windows.
+      aparse::MmapInputSource source(1);
+      ASSERT_TRUE(source.Open(file.path));
+      EXPECT_TRUE(expected == LexSource(lexer, &source, capacity));
+    }
+    for (size_t chunk_size : {1, 5, 4096}) {
+      int fd = open(file.path.c_str(), O_RDONLY);
+      ASSERT_LE(0, fd);
+      aparse::FdInputSource source(fd, chunk_size);
+      EXPECT_TRUE(expected == LexSource(lexer, &source, capacity));
+      close(fd);
+    }
+    for (size_t chunk_size : {3, 1000}) {
+      std::istringstream stream(input);
+      aparse::IstreamInputSource source(&stream, chunk_size);
+      EXPECT_TRUE(expected == LexSource(lexer, &source, capacity));
+    }
+  }
+}
+
+TEST(LexerInputIntegrationTest, Errors) {
+  aparse::Lexer lexer;
+  aparse::LexerBuilder::Build(LexerRules(), &lexer);
+  aparse::MmapInputSource missing_file;
+  EXPECT_FALSE(missing_file.Open("/tmp/aparse_no_such_file"));
+  TempFile file("12 ab # 34");
+  aparse::MmapInputSource source;
+  ASSERT_TRUE(source.Open(file.path));
+  aparse::LexerScopeBase scope;
+  TokenBuffer token_buffer(10);
+  auto lexer_instance = lexer.CreateInstance(&scope, &token_buffer);
+  aparse::Error error;
+  EXPECT_FALSE(lexer_instance.Feed(&source, &error));
+  EXPECT_EQ(aparse::Error::LEXER_ERROR_INVALID_TOKENS, error.status);
+  EXPECT_EQ(2, token_buffer.size());
+  // The rest of the input is left in the source.
+  EXPECT_EQ("# 34", source.Next().to_string());
+}
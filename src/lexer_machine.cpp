@@ -0,0 +1,52 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/lexer_machine.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace aparse {
+
+const char* LexerMachine::DFA::SkipSelfLoop(int32_t state,
+                                            const char* begin,
+                                            const char* end) const {
+  int n = num_exit_bytes[state];
+  const uint8_t* exits = &exit_bytes[state * kMaxExitBytes];
+  if (n == 0) {
+    return end;
+  }
+  if (n == 1) {
+    auto p = std::memchr(begin, exits[0], end - begin);
+    return (p == nullptr) ? end : static_cast<const char*>(p);
+  }
+  const char* p = begin;
+#if defined(__SSE2__)
+  const __m128i exit0 = _mm_set1_epi8(exits[0]);
+  const __m128i exit1 = _mm_set1_epi8(exits[1]);
+  const __m128i exit2 = _mm_set1_epi8(exits[n == 3 ? 2 : 1]);
+  for (; p + 16 <= end; p += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i match = _mm_or_si128(
+                      _mm_or_si128(_mm_cmpeq_epi8(bytes, exit0),
+                                   _mm_cmpeq_epi8(bytes, exit1)),
+                      _mm_cmpeq_epi8(bytes, exit2));
+    uint32_t mask = _mm_movemask_epi8(match);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+#endif
+  for (; p < end; p++) {
+    uint8_t c = *p;
+    if (c == exits[0] || c == exits[1] || c == exits[n - 1]) {
+      return p;
+    }
+  }
+  return end;
+}
+
+}  // namespace aparse
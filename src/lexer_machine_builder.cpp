@@ -3,11 +3,14 @@
 
 #include "src/lexer_machine_builder.hpp"
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 #include <vector>
 #include <unordered_set>
 #include <set>
+#include <map>
+#include <utility>
 
 #include <quick/unordered_map.hpp>
 #include <quick/unordered_set.hpp>
@@ -22,6 +25,10 @@ namespace aparse {
 using DFA = LexerMachineBuilder::DFA;
 using NFA = LexerMachineBuilder::NFA;
 
+constexpr int32_t DFA::kDeadState;
+constexpr int32_t DFA::kAlphabetSize;
+constexpr int32_t DFA::kMaxExitBytes;
+
 string DFA::DebugString() const {
   std::ostringstream oss;
   oss << "start_state = " << start_state << "\n";
@@ -205,70 +212,411 @@ void LexerMachineBuilder::ReduceNFA(NFA& nfa) {
   nfa.final_states = new_final_states;
 }
 
-void LexerMachineBuilder::BuildDFA(const NFA& nfa, DFA* output_dfa) {
+namespace {
+
+// Subsets of NFA states are dense bitsets of `num_words` 64-bit words. The
+// hash of a subset is the XOR of the `StateHash` of its members, so that it
+// can be maintained incrementally while the bits are being set.
+inline uint64_t StateHash(int nfa_state) {
+  uint64_t x = static_cast<uint64_t>(nfa_state) + 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+}  // namespace
+
+void LexerMachineBuilder::BuildDFA(const NFA& nfa,
+                                   DFA* output_dfa,
+                                   size_t* peak_memory_bytes) {
   DFA& dfa = *output_dfa;
-  dfa.start_state = 0;
-  qk::unordered_map<set<int>, int> dfa_index_map;
-  qk::unordered_set<set<int>> cur_states;
-  auto lAddDfaState = [&](const set<int> state) {
-    dfa_index_map[state] = dfa.states.size();
-    dfa.states.resize(dfa.states.size()+1);
-    cur_states.insert(state);
+  const int num_nfa_states = nfa.states.size();
+  const int num_words = (num_nfa_states + 63) / 64;
+  // Per-byte move table of the NFA: moves[offsets[s] ... offsets[s+1]) are
+  // the (alphabet, target) edges of the NFA state `s`.
+  vector<int> offsets(num_nfa_states + 1, 0);
+  vector<pair<Alphabet, int>> moves;
+  for (int s = 0; s < num_nfa_states; s++) {
+    for (auto& item : nfa.states[s].edges) {
+      APARSE_ASSERT(item.first >= 0 && item.first < DFA::kAlphabetSize,
+                    "Lexer alphabet out of range: " << item.first);
+      for (int ts : item.second) {
+        moves.emplace_back(item.first, ts);
+      }
+    }
+    offsets[s+1] = moves.size();
+  }
+  vector<uint64_t> final_bits(num_words, 0);
+  for (int fs : nfa.final_states) {
+    final_bits[fs / 64] |= (1ULL << (fs % 64));
+  }
+  // subsets[i * num_words ...] is the subset of the i'th DFA state.
+  vector<uint64_t> subsets;
+  vector<uint64_t> subset_hashes;
+  // Open addressing hash table of DFA state indices, -1 for the empty slots.
+  vector<int> table(16, -1);
+  auto lFind = [&](const uint64_t* bits, uint64_t hash) -> int& {
+    size_t mask = table.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+      int index = table[i];
+      if (index == -1 ||
+          (subset_hashes[index] == hash &&
+           std::equal(bits, bits + num_words,
+                      subsets.begin() + index * num_words))) {
+        return table[i];
+      }
+    }
   };
-  lAddDfaState(set<int>({nfa.start_state}));
-  while (!cur_states.empty()) {
-    auto &top = *cur_states.begin();
-    unordered_map<Alphabet, set<int>> next_states;
-    for (int nfa_state : top) {
-      for (auto& item : nfa.states[nfa_state].edges) {
-        for (auto& item2 : item.second) {
-          next_states[item.first].insert(item2);
+  // @slot must be the empty slot found by lFind. It's invalidated by the
+  // rehashing, hence the index of the new state is returned.
+  auto lAddDfaState = [&](const uint64_t* bits, uint64_t hash, int* slot) {
+    int index = dfa.states.size();
+    *slot = index;
+    subsets.insert(subsets.end(), bits, bits + num_words);
+    subset_hashes.push_back(hash);
+    dfa.states.resize(index + 1);
+    if (2 * dfa.states.size() > table.size()) {
+      vector<int> new_table(2 * table.size(), -1);
+      size_t mask = new_table.size() - 1;
+      for (int i = 0; i < dfa.states.size(); i++) {
+        size_t j = subset_hashes[i] & mask;
+        while (new_table[j] != -1) {
+          j = (j + 1) & mask;
         }
+        new_table[j] = i;
       }
+      table.swap(new_table);
     }
-    uint dfa_index_of_top = dfa_index_map[top];
-    for (auto& kv : next_states) {
-      if (not qk::ContainsKey(dfa_index_map, kv.second)) {
-        lAddDfaState(kv.second);
+    return index;
+  };
+  // Scratch space: the successor subset of the current DFA state for every
+  // byte, along with its hash and the list of bytes touched.
+  vector<uint64_t> next_bits(DFA::kAlphabetSize * num_words, 0);
+  vector<uint64_t> next_hashes(DFA::kAlphabetSize, 0);
+  vector<Alphabet> touched;
+  dfa.start_state = 0;
+  {
+    vector<uint64_t> start_bits(num_words, 0);
+    start_bits[nfa.start_state / 64] |= (1ULL << (nfa.start_state % 64));
+    uint64_t hash = StateHash(nfa.start_state);
+    lAddDfaState(start_bits.data(), hash, &lFind(start_bits.data(), hash));
+  }
+  // DFA states are processed in the order of their creation.
+  for (int d = 0; d < dfa.states.size(); d++) {
+    bool is_final = false;
+    for (int w = 0; w < num_words; w++) {
+      uint64_t word = subsets[d * num_words + w];
+      uint64_t final_word = word & final_bits[w];
+      if (not is_final && final_word != 0) {
+        // Label of the lowest final NFA state decides the label.
+        int fs = w * 64 + __builtin_ctzll(final_word);
+        dfa.states[d].label = nfa.states[fs].label;
+        dfa.final_states.insert(d);
+        is_final = true;
       }
-      dfa.states[dfa_index_of_top].edges[kv.first] = dfa_index_map[kv.second];
-    }
-    for (int nfa_state : top) {
-      if (ContainsKey(nfa.final_states, nfa_state)) {
-        dfa.states[dfa_index_of_top].label = nfa.states[nfa_state].label;
-        dfa.final_states.insert(dfa_index_of_top);
-        break;
+      while (word != 0) {
+        int s = w * 64 + __builtin_ctzll(word);
+        word &= word - 1;
+        for (int m = offsets[s]; m < offsets[s+1]; m++) {
+          Alphabet a = moves[m].first;
+          int ts = moves[m].second;
+          if (next_hashes[a] == 0) {
+            touched.push_back(a);
+          }
+          uint64_t& target_word = next_bits[a * num_words + ts / 64];
+          uint64_t bit = 1ULL << (ts % 64);
+          if ((target_word & bit) == 0) {
+            target_word |= bit;
+            next_hashes[a] ^= StateHash(ts);
+            // Zero is reserved for the untouched bytes.
+            next_hashes[a] += (next_hashes[a] == 0);
+          }
+        }
       }
     }
-    cur_states.erase(top);
+    for (Alphabet a : touched) {
+      const uint64_t* bits = &next_bits[a * num_words];
+      int* slot = &lFind(bits, next_hashes[a]);
+      dfa.states[d].edges[a] = (*slot == -1)
+                                ? lAddDfaState(bits, next_hashes[a], slot)
+                                : *slot;
+    }
+    for (Alphabet a : touched) {
+      std::fill_n(next_bits.begin() + a * num_words, num_words, 0);
+      next_hashes[a] = 0;
+    }
+    touched.clear();
+  }
+  if (peak_memory_bytes != nullptr) {
+    *peak_memory_bytes =
+        offsets.capacity() * sizeof(int) +
+        moves.capacity() * sizeof(pair<Alphabet, int>) +
+        (final_bits.capacity() + subsets.capacity() +
+         subset_hashes.capacity() + next_bits.capacity() +
+         next_hashes.capacity()) * sizeof(uint64_t) +
+        table.capacity() * sizeof(int) +
+        touched.capacity() * sizeof(Alphabet);
   }
 }
 
+// static
+void LexerMachineBuilder::MinimizeDFA(const DFA& dfa, DFA* output) {
+  // The partial @dfa is completed by an explicit dead state `dead`, which
+  // absorbs all the missing edges.
+  int num_states = dfa.states.size();
+  int dead = num_states;
+  std::map<Alphabet, int> alphabet_index;
+  for (auto& state : dfa.states) {
+    for (auto& item : state.edges) {
+      alphabet_index[item.first];
+    }
+  }
+  vector<Alphabet> alphabets;
+  for (auto& item : alphabet_index) {
+    item.second = alphabets.size();
+    alphabets.push_back(item.first);
+  }
+  int num_alphabets = alphabets.size();
+  // delta[s * num_alphabets + c] = target of the state `s` on alphabets[c].
+  vector<int> delta((num_states + 1) * num_alphabets, dead);
+  for (int i = 0; i < num_states; i++) {
+    for (auto& item : dfa.states[i].edges) {
+      delta[i * num_alphabets + alphabet_index.at(item.first)] = item.second;
+    }
+  }
+  // Inverse edges, grouped by alphabet and then by target state:
+  // Sources of the state `t` on alphabets[c] are
+  // inverse_sources[c][inverse_offset[c][t] ... inverse_offset[c][t+1]).
+  vector<vector<int>> inverse_offset(num_alphabets,
+                                     vector<int>(num_states + 3, 0));
+  vector<vector<int>> inverse_sources(num_alphabets,
+                                      vector<int>(num_states + 1));
+  for (int c = 0; c < num_alphabets; c++) {
+    auto& offset = inverse_offset[c];
+    for (int i = 0; i <= num_states; i++) {
+      offset[delta[i * num_alphabets + c] + 2]++;
+    }
+    for (int t = 0; t <= num_states; t++) {
+      offset[t + 1] += offset[t];
+    }
+    for (int i = 0; i <= num_states; i++) {
+      inverse_sources[c][offset[delta[i * num_alphabets + c] + 1]++] = i;
+    }
+  }
+  // Refinable partition: members of the block `b` are
+  // elements[blocks[b].begin ... blocks[b].end). The first blocks[b].marked
+  // members are the ones marked in the current splitting round.
+  struct Block {
+    int begin, end, marked;
+  };
+  vector<Block> blocks;
+  vector<int> elements(num_states + 1), location(num_states + 1);
+  vector<int> block_of(num_states + 1);
+  {
+    // Initial partition: non-final states (including dead) and then one
+    // block per label of the final states.
+    std::map<pair<bool, int>, vector<int>> initial_blocks;
+    for (int i = 0; i <= num_states; i++) {
+      bool is_final = (i != dead && ContainsKey(dfa.final_states, i));
+      initial_blocks[make_pair(is_final,
+                               is_final ? dfa.states[i].label : 0)]
+          .push_back(i);
+    }
+    int position = 0;
+    for (auto& item : initial_blocks) {
+      Block block = {position, position, 0};
+      for (int s : item.second) {
+        elements[position] = s;
+        location[s] = position++;
+        block_of[s] = blocks.size();
+      }
+      block.end = position;
+      blocks.push_back(block);
+    }
+  }
+  vector<int> worklist;
+  vector<bool> in_worklist;
+  for (int b = 0; b < blocks.size(); b++) {
+    worklist.push_back(b);
+    in_worklist.push_back(true);
+  }
+  vector<int> splitter, touched_blocks;
+  while (not worklist.empty()) {
+    int a = worklist.back();
+    worklist.pop_back();
+    in_worklist[a] = false;
+    splitter.assign(elements.begin() + blocks[a].begin,
+                    elements.begin() + blocks[a].end);
+    for (int c = 0; c < num_alphabets; c++) {
+      auto& offset = inverse_offset[c];
+      for (int t : splitter) {
+        for (int j = offset[t]; j < offset[t + 1]; j++) {
+          int s = inverse_sources[c][j];
+          auto& block = blocks[block_of[s]];
+          int marked_position = block.begin + block.marked;
+          if (location[s] < marked_position) {
+            continue;  // Already marked.
+          }
+          if (block.marked == 0) {
+            touched_blocks.push_back(block_of[s]);
+          }
+          int other = elements[marked_position];
+          std::swap(elements[location[s]], elements[marked_position]);
+          location[other] = location[s];
+          location[s] = marked_position;
+          block.marked++;
+        }
+      }
+      for (int y : touched_blocks) {
+        Block& block = blocks[y];
+        if (block.marked == block.end - block.begin) {
+          block.marked = 0;
+          continue;
+        }
+        // Split the marked members out of `y` into a new block `z`.
+        int z = blocks.size();
+        Block new_block = {block.begin, block.begin + block.marked, 0};
+        block.begin = new_block.end;
+        block.marked = 0;
+        blocks.push_back(new_block);
+        in_worklist.push_back(false);
+        for (int i = new_block.begin; i < new_block.end; i++) {
+          block_of[elements[i]] = z;
+        }
+        const Block& y_block = blocks[y];
+        if (in_worklist[y] ||
+            (new_block.end - new_block.begin <= y_block.end - y_block.begin)) {
+          worklist.push_back(z);
+          in_worklist[z] = true;
+        } else {
+          worklist.push_back(y);
+          in_worklist[y] = true;
+        }
+      }
+      touched_blocks.clear();
+    }
+  }
+  // Each block (except the dead one) becomes a state of @output. Blocks are
+  // numbered in the order of their smallest member, the smallest member
+  // being the representative of the block.
+  int dead_block = block_of[dead];
+  int start_block = block_of[dfa.start_state];
+  vector<int> new_index(blocks.size(), -1);
+  vector<int> representatives;
+  for (int i = 0; i < num_states; i++) {
+    int b = block_of[i];
+    if (new_index[b] == -1 && (b != dead_block || b == start_block)) {
+      new_index[b] = representatives.size();
+      representatives.push_back(i);
+    }
+  }
+  output->states.clear();
+  output->final_states.clear();
+  output->states.resize(representatives.size());
+  output->start_state = new_index[start_block];
+  for (int i = 0; i < representatives.size(); i++) {
+    int r = representatives[i];
+    auto& state = output->states[i];
+    for (auto& item : dfa.states[r].edges) {
+      int b = block_of[item.second];
+      if (new_index[b] != -1) {
+        state.edges[item.first] = new_index[b];
+      }
+    }
+    if (ContainsKey(dfa.final_states, r)) {
+      state.label = dfa.states[r].label;
+      output->final_states.insert(i);
+    }
+  }
+}
 
 // static
-void LexerMachineBuilder::MergeDFA(
-    const unordered_map<int, DFA>& dfa_map,
-    int main_dfa_index,
-    DFA* output_dfa,
-    unordered_map<int, int>* start_states_mapping) {
+void LexerMachineBuilder::MergeDFA(const vector<DFA>& dfa_list,
+                                   int main_dfa_index,
+                                   DFA* output_dfa,
+                                   vector<int32_t>* start_states) {
   int offset = 0;
-  for (auto& item : dfa_map) {
-    auto& dfa = item.second;
-    if (item.first == main_dfa_index) {
+  start_states->clear();
+  for (int i = 0; i < dfa_list.size(); i++) {
+    auto& dfa = dfa_list[i];
+    if (i == main_dfa_index) {
       output_dfa->start_state = offset + dfa.start_state;
     }
     qk::InsertToVector(dfa.states, &output_dfa->states);
     for (auto fs : dfa.final_states) {
       output_dfa->final_states.insert(offset + fs);
     }
-    for (int i = offset; i < offset + dfa.states.size(); i++) {
-      for (auto& item : output_dfa->states[i].edges) {
+    for (int j = offset; j < offset + dfa.states.size(); j++) {
+      for (auto& item : output_dfa->states[j].edges) {
         item.second += offset;
       }
     }
-    (*start_states_mapping)[item.first] = offset + dfa.start_state;
+    start_states->push_back(offset + dfa.start_state);
     offset += dfa.states.size();
   }
 }
 
+// static
+void LexerMachineBuilder::CompileDFA(DFA* dfa) {
+  constexpr int kAlphabetSize = DFA::kAlphabetSize;
+  int num_states = dfa->states.size();
+  // targets[s * kAlphabetSize + a] = target of the state `s` on the byte `a`.
+  vector<int32_t> targets(num_states * kAlphabetSize, DFA::kDeadState);
+  for (int i = 0; i < num_states; i++) {
+    for (auto& item : dfa->states[i].edges) {
+      APARSE_ASSERT(item.first >= 0 && item.first < kAlphabetSize,
+                    "Lexer alphabet out of range: " << item.first);
+      targets[i * kAlphabetSize + item.first] = item.second;
+    }
+  }
+  // Refine the partition of bytes, one state at a time. After processing
+  // the state `s`, bytes `a` and `b` are in the same class iff all the states
+  // in [0, s] have the same target on `a` and `b`.
+  vector<int> byte_class(kAlphabetSize, 0);
+  int num_classes = 1;
+  std::map<pair<int, int32_t>, int> new_classes;
+  for (int i = 0; i < num_states; i++) {
+    new_classes.clear();
+    for (int a = 0; a < kAlphabetSize; a++) {
+      auto key = make_pair(byte_class[a], targets[i * kAlphabetSize + a]);
+      auto it = new_classes.emplace(key, new_classes.size()).first;
+      byte_class[a] = it->second;
+    }
+    num_classes = new_classes.size();
+  }
+  dfa->num_alphabet_classes = num_classes;
+  dfa->alphabet_class.assign(byte_class.begin(), byte_class.end());
+  dfa->transition_table.assign(num_states * num_classes, DFA::kDeadState);
+  for (int i = 0; i < num_states; i++) {
+    for (int a = 0; a < kAlphabetSize; a++) {
+      dfa->transition_table[i * num_classes + byte_class[a]] =
+          targets[i * kAlphabetSize + a];
+    }
+  }
+  dfa->is_final_state.assign(num_states, 0);
+  for (int fs : dfa->final_states) {
+    dfa->is_final_state[fs] = 1;
+  }
+  dfa->is_terminal_state.assign(num_states, 0);
+  for (int fs : dfa->final_states) {
+    dfa->is_terminal_state[fs] = dfa->states[fs].edges.empty();
+  }
+  constexpr int kMaxExitBytes = DFA::kMaxExitBytes;
+  dfa->num_exit_bytes.assign(num_states, -1);
+  dfa->exit_bytes.assign(num_states * kMaxExitBytes, 0);
+  for (int i = 0; i < num_states; i++) {
+    vector<uint8_t> exits;
+    for (int a = 0; a < kAlphabetSize && exits.size() <= kMaxExitBytes; a++) {
+      if (targets[i * kAlphabetSize + a] != i) {
+        exits.push_back(a);
+      }
+    }
+    if (exits.size() <= kMaxExitBytes) {
+      dfa->num_exit_bytes[i] = exits.size();
+      std::copy(exits.begin(), exits.end(),
+                dfa->exit_bytes.begin() + i * kMaxExitBytes);
+    }
+  }
+}
+
 }  // namespace aparse
@@ -5,6 +5,7 @@
 #define APARSE_LEXER_MACHINE_BUILDER_HPP_
 
 #include <unordered_map>
+#include <vector>
 
 #include "aparse/regex.hpp"
 #include "aparse/utils/very_common_headers.hpp"
@@ -17,11 +18,28 @@ class LexerMachineBuilder {
   void ReduceNFA(LexerMachine::NFA& nfa);  // NOLINT
   using DFA = LexerMachine::DFA;
   using NFA = LexerMachine::NFA;
-  static void BuildDFA(const NFA& nfa, DFA* dfa);
-  static void MergeDFA(const std::unordered_map<int, DFA>& dfa_map,
-                       int main_dfa,
+  /** Subset construction. The subsets of NFA states are kept as dense
+   *  bitsets, hashed incrementally, and the DFA states are numbered in the
+   *  order of their discovery from the start state 0.
+   *  @peak_memory_bytes (optional) is set to the working memory used. */
+  static void BuildDFA(const NFA& nfa,
+                       DFA* dfa,
+                       size_t* peak_memory_bytes = nullptr);
+  /** Hopcroft's partition refinement. Two states of @dfa are merged iff they
+   *  are both non-final, or both final with the same `label`, and they agree
+   *  on every future input. States which can never reach a final state are
+   *  dropped. @dfa and @output must be different objects. */
+  static void MinimizeDFA(const DFA& dfa, DFA* output);
+  /** Concatenate the states of the DFAs of @dfa_list into @output_dfa.
+   *  (*start_states)[i] is set to the start state of the i'th DFA. */
+  static void MergeDFA(const std::vector<DFA>& dfa_list,
+                       int main_dfa_index,
                        DFA* output_dfa,
-                       std::unordered_map<int, int>* start_states_mapping);
+                       std::vector<int32_t>* start_states);
+  /** Compute the byte equivalence classes of @dfa and build its dense
+   *  `transition_table` (and the per-state flags) from its `states`. Must be
+   *  invoked after MergeDFA, i.e. once the state numbering is final. */
+  static void CompileDFA(DFA* dfa);
 };
 }  // namespace aparse
 
@@ -0,0 +1,157 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "src/lexer_machine_builder.hpp"
+
+#include <string>
+#include <vector>
+
+#include "quick/debug.hpp"
+#include "gtest/gtest.h"
+
+#include "src/regex_helpers.hpp"
+
+using aparse::LexerMachine;
+using aparse::LexerMachineBuilder;
+using aparse::Regex;
+using aparse::helpers::RangeRegex;
+using std::string;
+using std::vector;
+
+using uchar = unsigned char;
+using DFA = LexerMachine::DFA;
+
+namespace {
+
+Regex StringRegex(const string& s) {
+  Regex output(Regex::CONCAT);
+  for (auto c : s) {
+    output.children.emplace_back(Regex(uchar(c)));
+  }
+  return output;
+}
+
+DFA BuildDFA(const vector<Regex>& rules) {
+  Regex regex_union(Regex::UNION);
+  for (int i = 0; i < rules.size(); i++) {
+    regex_union.children.push_back(rules[i]);
+    regex_union.children.back().label = i + 1;
+  }
+  DFA dfa;
+  LexerMachineBuilder::BuildDFA(LexerMachineBuilder::BuildNFA(regex_union),
+                                &dfa);
+  return dfa;
+}
+
+// Returns the label of the DFA state reached after consuming @input, or -1 if
+// @input is not accepted.
+int Match(const DFA& dfa, const string& input) {
+  int state = dfa.start_state;
+  for (auto c : input) {
+    auto& edges = dfa.states[state].edges;
+    auto it = edges.find(uchar(c));
+    if (it == edges.end()) {
+      return -1;
+    }
+    state = it->second;
+  }
+  return dfa.final_states.count(state) ? dfa.states[state].label : -1;
+}
+
+}  // namespace
+
+TEST(LexerMachineBuilderTest, MinimizeDFA) {
+  auto keyword = [](const string& s) { return StringRegex(s); };
+  auto pet = Regex(Regex::UNION, {keyword("cat"), keyword("rat"),
+                                  keyword("bat")});
+  auto identifier = Regex(Regex::KPLUS, {RangeRegex(uchar('a'),
+                                                    uchar('z') + 1)});
+  auto number = Regex(Regex::KPLUS, {RangeRegex(uchar('0'), uchar('9') + 1)});
+  auto dfa = BuildDFA({keyword("int"), keyword("if"), keyword("in"),
+                       keyword("for"), pet, identifier, number});
+  DFA minimized;
+  LexerMachineBuilder::MinimizeDFA(dfa, &minimized);
+  EXPECT_LT(minimized.states.size(), dfa.states.size());
+  for (auto& input : {"int", "if", "in", "for", "i", "fo", "into", "forx",
+                      "abc", "0", "123", "", "1a", "-", "cat", "bat",
+                      "ca", "cats"}) {
+    EXPECT_EQ(Match(dfa, input), Match(minimized, input)) << input;
+  }
+  EXPECT_EQ(1, Match(minimized, "int"));
+  EXPECT_EQ(5, Match(minimized, "rat"));
+  EXPECT_EQ(6, Match(minimized, "into"));
+  EXPECT_EQ(7, Match(minimized, "123"));
+}
+
+TEST(LexerMachineBuilderTest, MinimizeDFAPreservesLabels) {
+  // "ac" and "bc" are the same language suffix, but different labels.
+  auto dfa1 = BuildDFA({StringRegex("ac"), StringRegex("bc")});
+  auto dfa2 = BuildDFA({Regex(Regex::UNION, {StringRegex("ac"),
+                                             StringRegex("bc")})});
+  DFA minimized1, minimized2;
+  LexerMachineBuilder::MinimizeDFA(dfa1, &minimized1);
+  LexerMachineBuilder::MinimizeDFA(dfa2, &minimized2);
+  EXPECT_EQ(5, minimized1.states.size());
+  EXPECT_EQ(3, minimized2.states.size());
+  EXPECT_EQ(1, Match(minimized1, "ac"));
+  EXPECT_EQ(2, Match(minimized1, "bc"));
+  EXPECT_EQ(1, Match(minimized2, "bc"));
+  EXPECT_EQ(-1, Match(minimized2, "cc"));
+}
+
+TEST(LexerMachineBuilderTest, AccelerableStates) {
+  auto not_new_line = Regex(Regex::UNION, {RangeRegex(0, uchar('\n')),
+                                           RangeRegex(uchar('\n') + 1, 256)});
+  auto comment = Regex(Regex::CONCAT, {Regex(uchar('#')),
+                                       Regex(Regex::KSTAR, {not_new_line})});
+  auto number = Regex(Regex::KPLUS, {RangeRegex(uchar('0'), uchar('9') + 1)});
+  DFA dfa;
+  LexerMachineBuilder::MinimizeDFA(BuildDFA({comment, number}), &dfa);
+  LexerMachineBuilder::CompileDFA(&dfa);
+  int state = dfa.Next(dfa.Next(dfa.start_state, uchar('#')), uchar('x'));
+  ASSERT_NE(DFA::kDeadState, state);
+  EXPECT_TRUE(dfa.IsAccelerable(state));
+  EXPECT_EQ(1, dfa.num_exit_bytes[state]);
+  EXPECT_EQ(uchar('\n'), dfa.exit_bytes[state * DFA::kMaxExitBytes]);
+  EXPECT_FALSE(dfa.IsAccelerable(dfa.start_state));
+  EXPECT_FALSE(dfa.IsAccelerable(dfa.Next(dfa.start_state, uchar('7'))));
+  // A number can always be extended, and so can a comment.
+  EXPECT_FALSE(dfa.IsTerminal(dfa.Next(dfa.start_state, uchar('7'))));
+  EXPECT_FALSE(dfa.IsTerminal(state));
+  string input = string(100, 'x') + "\n" + string(20, 'y');
+  EXPECT_EQ(input.data() + 100,
+            dfa.SkipSelfLoop(state, input.data(), input.data() +
+                                                  input.size()));
+  EXPECT_EQ(input.data() + 50,
+            dfa.SkipSelfLoop(state, input.data(), input.data() + 50));
+  // State looping on all the bytes except {'a', 'b', 'c'}.
+  auto not_abc = Regex(Regex::UNION, {RangeRegex(0, uchar('a')),
+                                      RangeRegex(uchar('d'), 256)});
+  DFA dfa2;
+  LexerMachineBuilder::MinimizeDFA(
+      BuildDFA({Regex(Regex::CONCAT, {Regex(uchar('x')),
+                                      Regex(Regex::KSTAR, {not_abc})})}),
+      &dfa2);
+  LexerMachineBuilder::CompileDFA(&dfa2);
+  int state2 = dfa2.Next(dfa2.start_state, uchar('x'));
+  EXPECT_EQ(3, dfa2.num_exit_bytes[state2]);
+  for (int i : {0, 5, 15, 16, 17, 40}) {
+    string input2 = string(i, 'z') + "c" + string(40, 'a');
+    EXPECT_EQ(input2.data() + i,
+              dfa2.SkipSelfLoop(state2, input2.data(),
+                                input2.data() + input2.size()));
+  }
+}
+
+TEST(LexerMachineBuilderTest, TerminalStates) {
+  // "ab" can't be extended, "a" can.
+  auto ab = Regex(Regex::CONCAT, {Regex(uchar('a')), Regex(uchar('b'))});
+  DFA dfa;
+  LexerMachineBuilder::MinimizeDFA(BuildDFA({Regex(uchar('a')), ab}), &dfa);
+  LexerMachineBuilder::CompileDFA(&dfa);
+  int a = dfa.Next(dfa.start_state, uchar('a'));
+  EXPECT_TRUE(dfa.IsFinal(a));
+  EXPECT_FALSE(dfa.IsTerminal(a));
+  EXPECT_TRUE(dfa.IsTerminal(dfa.Next(a, uchar('b'))));
+  EXPECT_FALSE(dfa.IsTerminal(dfa.start_state));
+}
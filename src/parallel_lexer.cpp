@@ -0,0 +1,259 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/parallel_lexer.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace aparse {
+
+namespace {
+
+struct RawToken {
+  int label;
+  Offset start, end;
+};
+
+struct ChunkTokens {
+  std::vector<RawToken> tokens;
+  // End of the last token.
+  Offset end_offset = 0;
+  bool failed = false;
+  Error::ErrorStatus error_status = Error::SUCCESS;
+  pair<Offset, Offset> error_position;
+};
+
+// Lex the tokens of [data, data+len) starting at @begin, from the
+// @start_state, as long as the token start is less than @stop. The last
+// token may end after @stop. Same semantics as LexerInstance::Feed followed
+// by LexerInstance::End.
+void LexTokens(const LexerMachine::DFA& dfa,
+               int32_t start_state,
+               const char* data,
+               Offset len,
+               Offset begin,
+               Offset stop,
+               ChunkTokens* output) {
+  Offset token_start = begin;
+  Offset i = begin;
+  while (token_start < stop) {
+    int32_t state = start_state;
+    while (i < len) {
+      int32_t next_state = dfa.Next(state, static_cast<unsigned char>(data[i]));
+      if (next_state == LexerMachine::DFA::kDeadState) {
+        break;
+      }
+      state = next_state;
+      i++;
+      if (dfa.IsAccelerable(state)) {
+        i = dfa.SkipSelfLoop(state, data + i, data + len) - data;
+      }
+    }
+    if (not dfa.IsFinal(state)) {
+      output->failed = true;
+      output->error_status = (i == len ? Error::LEXER_ERROR_INCOMPLETE_TOKENS
+                                       : Error::LEXER_ERROR_INVALID_TOKENS);
+      output->error_position = make_pair(token_start, i + 1);
+      break;
+    }
+    output->tokens.push_back(RawToken{dfa.states[state].label, token_start, i});
+    if (i == token_start) {
+      // Empty token: the next byte cannot be consumed from the start state.
+      output->failed = true;
+      output->error_status = Error::LEXER_ERROR_INVALID_TOKENS;
+      output->error_position = make_pair(token_start, i + 1);
+      break;
+    }
+    token_start = i;
+  }
+  output->end_offset = token_start;
+}
+
+}  // namespace
+
+ParallelLexer::ParallelLexer(const Lexer& lexer, int num_threads)
+  : lexer(&lexer), num_threads(std::max(num_threads, 1)) {
+  APARSE_ASSERT(lexer.IsInitialized());
+  for (int32_t section : lexer.jump_to_sections) {
+    if (section >= 0 && section != lexer.main_section_index) {
+      uses_sections = true;
+    }
+  }
+  for (int i = 1; i < this->num_threads; i++) {
+    workers.emplace_back(&ParallelLexer::Worker, this);
+  }
+}
+
+ParallelLexer::~ParallelLexer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+  }
+  task_available.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+void ParallelLexer::Worker() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      task_available.wait(lock, [this] {
+        return stopped || not pending_tasks.empty();
+      });
+      if (pending_tasks.empty()) {
+        return;
+      }
+      task = std::move(pending_tasks.front());
+      pending_tasks.pop_front();
+    }
+    task();
+  }
+}
+
+void ParallelLexer::RunOnPool(std::vector<std::function<void()>>* tasks) const {
+  if (tasks->empty()) {
+    return;
+  }
+  // The first task runs on the calling thread.
+  size_t num_pending = tasks->size() - 1;
+  std::condition_variable all_done;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 1; i < tasks->size(); i++) {
+      auto& task = (*tasks)[i];
+      // `all_done` is notified under the lock, so that it's not used once
+      // this function returns.
+      pending_tasks.push_back([&] {
+        task();
+        std::lock_guard<std::mutex> done_lock(mutex);
+        if (--num_pending == 0) {
+          all_done.notify_one();
+        }
+      });
+    }
+  }
+  task_available.notify_all();
+  (*tasks)[0]();
+  std::unique_lock<std::mutex> lock(mutex);
+  all_done.wait(lock, [&] { return num_pending == 0; });
+}
+
+bool ParallelLexer::Lex(const char* data, size_t input_len,
+                        TokenBuffer* output, Error* error) const {
+  if (uses_sections) {
+    *error = Error(Error::LEXER_ERROR_UNSUPPORTED_SECTIONS);
+    return false;
+  }
+  const auto& dfa = lexer->machine.dfa;
+  const int32_t start_state = lexer->section_start_states[
+                                                  lexer->main_section_index];
+  const Offset len = input_len;
+  int num_chunks = static_cast<int>(
+                       std::max<Offset>(1, std::min<Offset>(num_threads, len)));
+  std::vector<Offset> boundaries(num_chunks + 1);
+  for (int i = 0; i <= num_chunks; i++) {
+    boundaries[i] = static_cast<int64_t>(len) * i / num_chunks;
+  }
+  std::vector<ChunkTokens> chunks(num_chunks);
+  {
+    std::vector<std::function<void()>> tasks;
+    for (int i = 0; i < num_chunks; i++) {
+      tasks.push_back([&, i] {
+        LexTokens(dfa, start_state, data, len, boundaries[i],
+                  boundaries[i+1], &chunks[i]);
+      });
+    }
+    RunOnPool(&tasks);
+  }
+  auto lFail = [&](Error::ErrorStatus status,
+                   pair<Offset, Offset> position) {
+    *error = Error(status).Position(position)();
+    return false;
+  };
+  const auto& keyword_tables = lexer->keyword_tables;
+  auto lAppend = [&](const RawToken& token) {
+    int label = token.label;
+    if (label < keyword_tables.size() && not keyword_tables[label].empty()) {
+      int keyword_label = keyword_tables[label].Find(data + token.start,
+                                                     token.end - token.start);
+      label = keyword_label > 0 ? keyword_label : label;
+    }
+    if (lexer->skip_tokens[label]) {
+      return true;
+    }
+    return output->Append(lexer->token_ids[label], token.start, token.end);
+  };
+  auto lAppendAll = [&](const ChunkTokens& chunk, size_t begin) {
+    for (size_t i = begin; i < chunk.tokens.size(); i++) {
+      if (not lAppend(chunk.tokens[i])) {
+        auto& token = chunk.tokens[i];
+        return lFail(Error::LEXER_ERROR_TOKEN_BUFFER_FULL,
+                     make_pair(token.start, token.end + 1));
+      }
+    }
+    if (chunk.failed) {
+      return lFail(chunk.error_status, chunk.error_position);
+    }
+    return true;
+  };
+  if (len == 0) {
+    ChunkTokens chunk;
+    if (dfa.IsFinal(start_state)) {
+      chunk.tokens.push_back(RawToken{dfa.states[start_state].label, 0, 0});
+    } else {
+      chunk.failed = true;
+      chunk.error_status = Error::LEXER_ERROR_INCOMPLETE_TOKENS;
+      chunk.error_position = make_pair(0, 1);
+    }
+    return lAppendAll(chunk, 0);
+  }
+  if (not lAppendAll(chunks[0], 0)) {
+    return false;
+  }
+  Offset position = chunks[0].end_offset;
+  for (int i = 1; i < num_chunks; i++) {
+    const auto& chunk = chunks[i];
+    auto lByStart = [](const RawToken& token, Offset start) {
+      return token.start < start;
+    };
+    while (position < boundaries[i+1]) {
+      auto it = std::lower_bound(chunk.tokens.begin(), chunk.tokens.end(),
+                                 position, lByStart);
+      if (it != chunk.tokens.end() && it->start == position) {
+        if (not lAppendAll(chunk, it - chunk.tokens.begin())) {
+          return false;
+        }
+        position = chunk.end_offset;
+        break;
+      }
+      // Not synchronized with the speculation yet. Lex the next token
+      // sequentially.
+      ChunkTokens next_token;
+      LexTokens(dfa, start_state, data, len, position, position + 1,
+                &next_token);
+      if (not lAppendAll(next_token, 0)) {
+        return false;
+      }
+      position = next_token.end_offset;
+    }
+  }
+  return true;
+}
+
+void ParallelLexer::LexOrDie(const char* data, size_t len,
+                             TokenBuffer* output) const {
+  Error error;
+  if (not Lex(data, len, output, &error)) {
+    throw error;
+  }
+}
+
+}  // namespace aparse
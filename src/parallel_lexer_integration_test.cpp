@@ -0,0 +1,166 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "aparse/parallel_lexer.hpp"
+
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aparse/lexer_builder.hpp"
+#include "gtest/gtest.h"
+
+using aparse::Alphabet;
+using aparse::Lexer;
+using aparse::LexerGrammar;
+using aparse::TokenBuffer;
+using std::string;
+using std::vector;
+
+enum TokenType {NUMBER, IDENTIFIER, STRING, PLUS, COMMENT, KEYWORD};
+
+namespace {
+
+LexerGrammar LexerRules() {
+  using Rule = LexerGrammar::Rule;
+  LexerGrammar lexer_rules;
+  lexer_rules.rules = {
+    {0, {
+      Rule("[0-9]+").Token(NUMBER),
+      Rule("[a-z]+").Token(IDENTIFIER).Keyword(Rule("abc").Token(KEYWORD)),
+      Rule("\"[^\"]*\"").Token(STRING),
+      Rule("\\+").Token(PLUS),
+      Rule("#[^\n]*").Token(COMMENT),
+      Rule("( |\n)+").Skip(),
+    }}
+  };
+  return lexer_rules;
+}
+
+// Strings and comments contain the other tokens, so that the speculative
+// lexing of the chunks goes wrong whenever a chunk starts inside them.
+string RandomInput(int num_tokens) {
+  std::mt19937 rng(1196);
+  vector<string> pieces = {"44", "abc", "\" 4 + x \"", "+", "# 1 + \"a\" 2\n",
+                           " ", "\n", "\"\"", "7", "# #\n", "abcd"};
+  string output;
+  for (int i = 0; i < num_tokens; i++) {
+    output += pieces[rng() % pieces.size()];
+    output += " ";
+  }
+  return output;
+}
+
+struct Tokens {
+  vector<Alphabet> token_ids;
+  vector<aparse::Offset> starts, ends;
+  bool operator==(const Tokens& other) const {
+    return token_ids == other.token_ids && starts == other.starts &&
+           ends == other.ends;
+  }
+};
+
+Tokens ToTokens(const TokenBuffer& token_buffer) {
+  Tokens output;
+  output.token_ids = token_buffer.Alphabets();
+  output.starts.assign(token_buffer.starts(),
+                       token_buffer.starts() + token_buffer.size());
+  output.ends.assign(token_buffer.ends(),
+                     token_buffer.ends() + token_buffer.size());
+  return output;
+}
+
+}  // namespace
+
+TEST(ParallelLexerIntegrationTest, SameAsSequential) {
+  Lexer lexer;
+  aparse::LexerBuilder::Build(LexerRules(), &lexer);
+  string input = RandomInput(3000);
+  aparse::LexerScopeBase scope;
+  TokenBuffer sequential_output(input.size() + 1);
+  auto lexer_instance = lexer.CreateInstance(&scope, &sequential_output);
+  lexer_instance.FeedOrDie(input);
+  lexer_instance.EndOrDie();
+  auto expected = ToTokens(sequential_output);
+  for (int num_threads : {1, 2, 3, 7, 16, 100}) {
+    aparse::ParallelLexer parallel_lexer(lexer, num_threads);
+    TokenBuffer output(input.size() + 1);
+    parallel_lexer.LexOrDie(input.data(), input.size(), &output);
+    EXPECT_TRUE(expected == ToTokens(output)) << num_threads;
+  }
+}
+
+TEST(ParallelLexerIntegrationTest, Errors) {
+  Lexer lexer;
+  aparse::LexerBuilder::Build(LexerRules(), &lexer);
+  string input = RandomInput(500);
+  for (string suffix : {"4 ? 5", "\"abc"}) {
+    string bad_input = input + suffix + input;
+    aparse::LexerScopeBase scope;
+    TokenBuffer sequential_output(bad_input.size() + 1);
+    auto lexer_instance = lexer.CreateInstance(&scope, &sequential_output);
+    aparse::Error expected_error;
+    EXPECT_FALSE(lexer_instance.Feed(bad_input, &expected_error) &&
+                 lexer_instance.End(&expected_error));
+    for (int num_threads : {1, 4, 9}) {
+      aparse::ParallelLexer parallel_lexer(lexer, num_threads);
+      TokenBuffer output(bad_input.size() + 1);
+      aparse::Error error;
+      EXPECT_FALSE(parallel_lexer.Lex(bad_input.data(), bad_input.size(),
+                                      &output, &error));
+      EXPECT_EQ(expected_error.status, error.status);
+      EXPECT_EQ(expected_error.error_position, error.error_position);
+      EXPECT_TRUE(ToTokens(sequential_output) == ToTokens(output));
+    }
+  }
+}
+
+// The same ParallelLexer (and its threads) used for many inputs, also from
+// multiple threads at once.
+TEST(ParallelLexerIntegrationTest, Reuse) {
+  Lexer lexer;
+  aparse::LexerBuilder::Build(LexerRules(), &lexer);
+  aparse::ParallelLexer parallel_lexer(lexer, 4);
+  string input = RandomInput(1000);
+  aparse::LexerScopeBase scope;
+  TokenBuffer sequential_output(input.size() + 1);
+  auto lexer_instance = lexer.CreateInstance(&scope, &sequential_output);
+  lexer_instance.FeedOrDie(input);
+  lexer_instance.EndOrDie();
+  auto expected = ToTokens(sequential_output);
+  auto lLex = [&] {
+    for (int i = 0; i < 20; i++) {
+      TokenBuffer output(input.size() + 1);
+      parallel_lexer.LexOrDie(input.data(), input.size(), &output);
+      EXPECT_TRUE(expected == ToTokens(output));
+    }
+  };
+  std::thread thread(lLex);
+  lLex();
+  thread.join();
+}
+
+TEST(ParallelLexerIntegrationTest, Sections) {
+  using Rule = LexerGrammar::Rule;
+  LexerGrammar lexer_rules;
+  lexer_rules.rules = {
+    {0, {
+      Rule("[0-9]+").Token(NUMBER),
+      Rule("\"").Token(STRING).JumpTo(1),
+    }},
+    {1, {
+      Rule("[^\"]+").Token(STRING),
+      Rule("\"").Token(STRING).JumpTo(0),
+    }}
+  };
+  Lexer lexer;
+  aparse::LexerBuilder::Build(lexer_rules, &lexer);
+  aparse::ParallelLexer parallel_lexer(lexer, 2);
+  string input = "12\"ab\"";
+  TokenBuffer output(10);
+  aparse::Error error;
+  EXPECT_FALSE(parallel_lexer.Lex(input.data(), input.size(), &output,
+                                  &error));
+  EXPECT_EQ(aparse::Error::LEXER_ERROR_UNSUPPORTED_SECTIONS, error.status);
+}
@@ -41,7 +41,7 @@ struct RegexRuleParserScope: ParserScopeBase<ParsedGrammarRule> {
   const string* content;
   const vector<Token> *tokens;
   const unordered_map<std::string, TokenType> token_string_to_alphabet_mapping;
-  string TokenString(int alphabet_index) const;
+  string TokenString(Offset alphabet_index) const;
 };
 
 bool BuildGrammarRegexLexer(Lexer* lexer) {
@@ -327,7 +327,7 @@ string ParsedGrammarRule::DebugString() const {
   return oss.str();
 }
 
-string RegexRuleParserScope::TokenString(int alphabet_index) const {
+string RegexRuleParserScope::TokenString(Offset alphabet_index) const {
   auto range = tokens->at(alphabet_index).second;
   return content->substr(range.first, range.second - range.first);
 }
@@ -9,6 +9,8 @@
 
 #include "src/abstract_core_parser.hpp"
 #include "src/v2/core_parser.hpp"
+#include "src/v2/deterministic_core_parser.hpp"
+#include "src/v2/transition_cache.hpp"
 
 namespace aparse {
 
@@ -78,16 +80,26 @@ ParserInstance::ParserInstance(const Parser& parser) {
 
 void ParserInstance::Init(const Parser& parser) {
   APARSE_ASSERT(parser.IsFinalized());
-  core_parser.reset(new aparse::v2::CoreParser(parser.machine.get()));
+  if (parser.machine_type == Parser::VERY_LOW_COMPRESSION) {
+    core_parser.reset(
+        new aparse::v2::DeterministicCoreParser(parser.machine.get()));
+  } else {
+    core_parser.reset(new aparse::v2::CoreParser(
+        parser.machine.get(),
+        static_cast<v2::TransitionCache*>(parser.transition_cache.get())));
+  }
   syntax_tree_maker = parser.syntax_tree_maker.get();
 }
 
 bool Parser::Finalize() {
-  (void)machine_type;
   APARSE_ASSERT(machine != nullptr);
   APARSE_ASSERT(rule_actions.size() > 0);
   APARSE_ASSERT(rule_actions.size() == rule_atoms.size());
   APARSE_ASSERT(rule_actions.size() == rule_non_terminals.size());
+  if (machine_type == VERY_HIGH_COMPRESSION) {
+    transition_cache.reset(new v2::TransitionCache(
+        static_cast<const v2::AParseMachine*>(machine.get())));
+  }
   syntax_tree_maker.reset(new SyntaxTreeMaker(rule_actions,
                                               rule_atoms,
                                               rule_non_terminals));
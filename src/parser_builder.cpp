@@ -7,21 +7,13 @@
 
 #include "quick/debug_stream.hpp"
 
+#include "src/helpers.hpp"
 #include "src/internal_parser_builder.hpp"
 #include "src/parse_regex_rule.hpp"
 
 namespace aparse {
 namespace helpers {
 
-uint64_t SimpleChecksum(const std::string& input) {
-  uint64_t h = 14695981039346656037U;
-  for (int i = 0; i < input.size(); i++) {
-    h = static_cast<unsigned char>(input[i]) ^ (h * 1099511628211U);
-  }
-  return h;
-}
-
-
 uint64_t AdvanceParserRulesToGrammarHash(const ParserGrammar& grammar) {
   std::ostringstream oss;
   oss << std::hex << std::setfill('0') << std::setw(4);
@@ -75,6 +67,12 @@ bool ParserBuilder::Import(const string& serialized_parser,
 
 void ParserBuilder::Build(const ParserGrammar& parser_rules,
                           Parser* parser) {
+  Build(parser_rules, Parser::VERY_HIGH_COMPRESSION, parser);
+}
+
+void ParserBuilder::Build(const ParserGrammar& parser_rules,
+                          Parser::AParseMachineType machine_type,
+                          Parser* parser) {
   if (not parser->IsFinalized()) {
     vector<string> rule_strings;
     for (auto& rule : parser_rules.rules) {
@@ -89,7 +87,8 @@ void ParserBuilder::Build(const ParserGrammar& parser_rules,
     for (auto& rule : parser_rules.rules) {
       rule_actions.push_back(rule.action);
     }
-    InternalParserBuilder::Build(grammar, rule_actions, parser);
+    InternalParserBuilder::Build(grammar, rule_actions, machine_type,
+                                 parser);
   }
 }
 
@@ -193,6 +193,16 @@ TEST_F(ParserBuilderIntegrationTest, Basic) {
                   .Eval(), 85369);
 }
 
+TEST_F(ParserBuilderIntegrationTest, VeryLowCompression) {
+  Parser parser;
+  ParserBuilder::Build(MyGrammar(), Parser::VERY_LOW_COMPRESSION, &parser);
+  auto p = parser.CreateInstance();
+  EXPECT_EQ(Parse("3+5*6", p).Eval(), 33);
+  EXPECT_EQ(Parse("3*(5+(5+2+4+(22+5)+(33))+44)", p).Eval(), 360);
+  EXPECT_EQ(Parse(" 433 + 88 *( 445 + 99 + 44 * 8 +(22 + 5)+( 3+ 33))+544",
+                  p).Eval(), 85369);
+}
+
 TEST_F(ParserBuilderIntegrationTest, DISABLED_ImportExport) {
   auto grammar = MyGrammar();
   string parser_export = ParserBuilder::Export(parser_main, grammar);
@@ -3,8 +3,10 @@
 
 #include "src/v2/aparse_machine.hpp"
 
+#include <algorithm>
 #include <vector>
 #include <map>
+#include <set>
 #include <unordered_set>
 #include <unordered_map>
 #include <utility>
@@ -101,6 +103,7 @@ void AParseMachine::Serialize(qk::OByteStream& bs) const {
 void AParseMachine::Deserialize(qk::IByteStream& bs) {
   bs >> nfa_map >> start_state >> final_states >> nfa_lookup_map
      >> enclosed_subnfa_map;
+  InternStates();
 }
 
 pair<int, int> NFAState::GetI(int i) const {
@@ -394,6 +397,189 @@ std::unordered_set<Alphabet> AParseMachine::PossibleAlphabets(
   return output;
 }
 
+void AParseMachine::InternStates() {
+  interned_states.clear();
+  interned_edges.clear();
+  interned_edges_index.clear();
+  num_interned_alphabets = 0;
+  is_final_interned_state.clear();
+  interned_enclosed_start_states.clear();
+  NFAStateMap<StateId> state_ids;
+  // Breadth first search over the reachable states, ids are assigned in the
+  // order of discovery. The states and the alphabets are visited in sorted
+  // order, so that the ids don't depend on the order of hash tables, and
+  // remain the same after Export and Import.
+  auto lLess = [](const NFAState& a, const NFAState& b) {
+    if (a.GetNumber() != b.GetNumber()) {
+      return a.GetNumber() < b.GetNumber();
+    }
+    return a.GetFullPath() < b.GetFullPath();
+  };
+  auto lIntern = [&](const NFAState& state) {
+    auto it = state_ids.find(state);
+    if (it != state_ids.end()) {
+      return it->second;
+    }
+    StateId id = interned_states.size();
+    state_ids.emplace(state, id);
+    interned_states.push_back(state);
+    return id;
+  };
+  // Vector<Pair(target state, its ParsingStream)>
+  using Targets = vector<pair<NFAState, const ParsingStream*>>;
+  // A target may be found at more than one suffix of the source state, its
+  // ParsingStream is taken from the shortest suffix stripped, as done in
+  // GetParsingStream.
+  auto lInternAll = [&](Targets* targets,
+                        std::vector<StateId>* states,
+                        std::vector<ParsingStream>* parsing_streams) {
+    auto lFirstLess = [&](const Targets::value_type& a,
+                          const Targets::value_type& b) {
+      return lLess(a.first, b.first);
+    };
+    auto lFirstEqual = [](const Targets::value_type& a,
+                          const Targets::value_type& b) {
+      return a.first == b.first;
+    };
+    std::stable_sort(targets->begin(), targets->end(), lFirstLess);
+    targets->erase(std::unique(targets->begin(), targets->end(), lFirstEqual),
+                   targets->end());
+    for (auto& target : *targets) {
+      states->push_back(lIntern(target.first));
+      parsing_streams->push_back(*target.second);
+    }
+  };
+  interned_start_state = lIntern(start_state);
+  std::set<int> enclosed_non_terminals;
+  qk::STLGetKeys(enclosed_subnfa_map, &enclosed_non_terminals);
+  for (int ent : enclosed_non_terminals) {
+    interned_enclosed_start_states[ent] =
+        lIntern(enclosed_subnfa_map.at(ent).start_state);
+  }
+  for (StateId id = 0; id < interned_states.size(); id++) {
+    // `interned_states` may be reallocated by lIntern.
+    NFAState state = interned_states[id];
+    std::map<Alphabet, InternedEdges> edges;
+    std::map<Alphabet, Targets> next_states;
+    // Map(alphabet -> Map(enclosed-non-terminal -> Targets))
+    std::map<Alphabet, std::map<int, Targets>> special_next_states;
+    for (auto& item : GetOutgoingEdgesList(state)) {
+      for (auto& alphabet_edges : *item.second) {
+        auto& targets = next_states[alphabet_edges.first];
+        for (auto& target : alphabet_edges.second) {
+          targets.emplace_back(
+              target.first.AddPrefixFromOther(state, item.first),
+              &target.second);
+        }
+      }
+    }
+    for (auto& item : GetSpecialOutgoingEdgesList(state)) {
+      for (auto& alphabet_edges : *item.second) {
+        Alphabet a = alphabet_edges.first;
+        auto& special_targets = special_next_states[a];
+        for (auto& ent_edges : alphabet_edges.second) {
+          edges[a].stack_ops.push_back(ent_edges.second.first);
+          auto& targets = special_targets[ent_edges.first];
+          for (auto& target : ent_edges.second.second) {
+            targets.emplace_back(
+                target.first.AddPrefixFromOther(state, item.first),
+                &target.second);
+          }
+        }
+      }
+    }
+    std::set<Alphabet> alphabets;
+    qk::STLGetKeys(next_states, &alphabets);
+    qk::STLGetKeys(special_next_states, &alphabets);
+    for (Alphabet a : alphabets) {
+      auto& alphabet_edges = edges[a];
+      lInternAll(&next_states[a],
+                 &alphabet_edges.next_states,
+                 &alphabet_edges.parsing_streams);
+      for (auto& item : special_next_states[a]) {
+        alphabet_edges.special_next_states.emplace_back(
+            item.first, std::vector<StateId>());
+        alphabet_edges.special_parsing_streams.emplace_back();
+        lInternAll(&item.second,
+                   &alphabet_edges.special_next_states.back().second,
+                   &alphabet_edges.special_parsing_streams.back());
+      }
+    }
+    interned_edges.emplace_back(std::make_move_iterator(edges.begin()),
+                                std::make_move_iterator(edges.end()));
+    if (not alphabets.empty()) {
+      APARSE_ASSERT(*alphabets.begin() >= 0);
+      num_interned_alphabets = std::max<uint32_t>(num_interned_alphabets,
+                                                  *alphabets.rbegin() + 1);
+    }
+    is_final_interned_state.push_back(IsFinalState(state));
+  }
+  interned_edges_index.assign(
+      interned_states.size() * num_interned_alphabets, -1);
+  for (StateId id = 0; id < interned_states.size(); id++) {
+    for (size_t i = 0; i < interned_edges[id].size(); i++) {
+      interned_edges_index[static_cast<size_t>(id) * num_interned_alphabets +
+                           interned_edges[id][i].first] = i;
+    }
+  }
+}
+
+const AParseMachine::ParsingStream& AParseMachine::GetInternedParsingStream(
+    StateId source,
+    Alphabet a,
+    StateId target) const {
+  auto edges = FindEdges(source, a);
+  APARSE_ASSERT(edges != nullptr);
+  auto& next_states = edges->next_states;
+  auto it = std::find(next_states.begin(), next_states.end(), target);
+  APARSE_ASSERT(it != next_states.end());
+  return edges->parsing_streams[it - next_states.begin()];
+}
+
+const AParseMachine::ParsingStream&
+AParseMachine::GetInternedSpecialParsingStream(StateId source,
+                                               Alphabet a,
+                                               int e_non_terminal,
+                                               StateId target) const {
+  auto edges = FindEdges(source, a);
+  APARSE_ASSERT(edges != nullptr);
+  auto& special_next_states = edges->special_next_states;
+  auto item = std::find_if(special_next_states.begin(),
+                           special_next_states.end(),
+                           [&](const pair<int, std::vector<StateId>>& x) {
+                             return x.first == e_non_terminal;
+                           });
+  APARSE_ASSERT(item != special_next_states.end());
+  auto it = std::find(item->second.begin(), item->second.end(), target);
+  APARSE_ASSERT(it != item->second.end());
+  return edges->special_parsing_streams[item - special_next_states.begin()]
+                                       [it - item->second.begin()];
+}
+
+AParseMachine::StackOperation::OperationType
+AParseMachine::GetInternedStackOps(
+    const std::vector<StateId>& states,
+    Alphabet a,
+    std::vector<std::pair<int, StateId>>* sources) const {
+  auto op_type = StackOperation::NOP;
+  sources->clear();
+  for (StateId s : states) {
+    auto edges = FindEdges(s, a);
+    if (edges == nullptr) continue;
+    for (auto& op : edges->stack_ops) {
+      auto it = std::find_if(sources->begin(), sources->end(),
+                             [&](const std::pair<int, StateId>& x) {
+                               return x.first == op.enclosed_non_terminal;
+                             });
+      if (it == sources->end()) {
+        sources->emplace_back(op.enclosed_non_terminal, s);
+      }
+      op_type = op.type;
+    }
+  }
+  return op_type;
+}
+
 // ToDo(Mohit): So many copies of serialized_machine are created in
 // import/export. Optimise it.
 // Format Version - 3
@@ -166,6 +166,61 @@ struct AParseMachine : public quick::AbstractType {
   bool Import(const std::string& serialized_machine);
   std::unordered_set<Alphabet> PossibleAlphabets(const NFAState& state) const;
 
+  /** Dense id of a reachable NFAState. */
+  using StateId = uint32_t;
+  /** Outgoing edges of an interned state on an alphabet. */
+  struct InternedEdges {
+    // Same as GetNextStates.
+    std::vector<StateId> next_states;
+    // parsing_streams[i] is the ParsingStream of the edge to next_states[i].
+    std::vector<ParsingStream> parsing_streams;
+    // Same as GetNextStackOps.
+    std::vector<StackOperation> stack_ops;
+    // Vector<Pair(enclosed-non-terminal, same as GetSpecialNextStates)>
+    std::vector<std::pair<int, std::vector<StateId>>> special_next_states;
+    // special_parsing_streams[i][j] is the ParsingStream of the edge to
+    // special_next_states[i].second[j].
+    std::vector<std::vector<ParsingStream>> special_parsing_streams;
+  };
+
+  /** Assign the dense ids {0, 1, ...} to all the NFAStates reachable from
+   *  `start_state` and from the start states of the enclosed sub-NFAs, and
+   *  precompute their edges in terms of these ids. The edges found at every
+   *  suffix of a state are merged into a single list, so that the suffixes
+   *  are walked only here.
+   *  Called once the machine is built or deserialized. */
+  void InternStates();
+
+  /** Stack operation on @a from the interned @states. The first source
+   *  state of each enclosed-non-terminal is stored in @sources as
+   *  Vector<Pair(enclosed-non-terminal, source state)>. */
+  StackOperation::OperationType GetInternedStackOps(
+      const std::vector<StateId>& states,
+      Alphabet a,
+      std::vector<std::pair<int, StateId>>* sources) const;
+
+  /** Same as GetParsingStream, for the interned states. */
+  const ParsingStream& GetInternedParsingStream(StateId source,
+                                                Alphabet a,
+                                                StateId target) const;
+
+  /** Same as GetSpecialParsingStream, for the interned states. */
+  const ParsingStream& GetInternedSpecialParsingStream(
+      StateId source,
+      Alphabet a,
+      int e_non_terminal,
+      StateId target) const;
+
+  /** Outgoing edges of the interned state @s on @a, or nullptr. */
+  inline const InternedEdges* FindEdges(StateId s, Alphabet a) const {
+    if (static_cast<uint32_t>(a) >= num_interned_alphabets) {
+      return nullptr;
+    }
+    int32_t index = interned_edges_index[
+                        static_cast<size_t>(s) * num_interned_alphabets + a];
+    return (index < 0) ? nullptr : &interned_edges[s][index].second;
+  }
+
   std::unordered_map<int, NFA> nfa_map;
   NFAState start_state;
   NFAStateMap<ParsingStream> final_states;
@@ -173,6 +228,26 @@ struct AParseMachine : public quick::AbstractType {
   // nfa_state -> index of the NFA having this nfa_state as local state.
   NFAStateMap<int> nfa_lookup_map;
   std::unordered_map<int, EnclosedSubNFA> enclosed_subnfa_map;
+
+  /** Interned form of the fields above, used by CoreParser so that it
+   *  neither hashes nor copies the NFAStates while parsing. Computed by
+   *  InternStates, hence not serialized.
+   *  interned_states[id] is the NFAState with the `id`, kept for debugging
+   *  and for constructing the parse tree. */
+  std::vector<NFAState> interned_states;
+  /** interned_edges[id] is Vector<Pair(alphabet, InternedEdges)> of the
+   *  state with the `id`, sorted by the alphabet. */
+  std::vector<std::vector<std::pair<Alphabet, InternedEdges>>> interned_edges;
+  /** interned_edges_index[id * num_interned_alphabets + alphabet] is the
+   *  index of the alphabet in interned_edges[id], or -1. Alphabets are
+   *  non-negative and small, so FindEdges is a single array lookup. */
+  std::vector<int32_t> interned_edges_index;
+  /** 1 + the largest alphabet having an interned edge. */
+  uint32_t num_interned_alphabets = 0;
+  std::vector<uint8_t> is_final_interned_state;
+  StateId interned_start_state = 0;
+  /** Map(enclosed-non-terminal -> id of the start state of its sub-NFA) */
+  std::unordered_map<int, StateId> interned_enclosed_start_states;
   bool initialized = false;
 
  private:
@@ -461,6 +461,7 @@ void AParseMachineBuilder::ExportToAParseMachine(AParseMachine* output) const {
       lExportToNFALookupMap(nfa, nt);
     }
   }
+  output->InternStates();
   output->initialized = true;
 }
 
@@ -3,7 +3,7 @@
 
 #include "src/v2/core_parser.hpp"
 
-#include <tuple>
+#include <algorithm>
 #include <unordered_set>
 #include <unordered_map>
 #include <sstream>
@@ -14,89 +14,42 @@
 
 namespace aparse {
 namespace v2 {
-using NFAState = AParseMachine::NFAState;
 using StackOperation = AParseMachine::StackOperation;
-using NFAStateSet = qk::unordered_set<NFAState>;
 using ParsingStream = AParseMachine::ParsingStream;
-template<typename T> using NFAStateMap = qk::unordered_map<NFAState, T>;
-
-NFAStateMap<NFAState> CurrentState::NextStatesMap(
-      Alphabet alphabet,
-      const AParseMachine& machine) const {
-  NFAStateMap<NFAState> next_states_map;
-  for (auto& s : nfa_states) {
-    auto ns = machine.GetNextStates(s, alphabet);
-    for (auto& item : ns) {
-      next_states_map.emplace(item, s);
-    }
-  }
-  return next_states_map;
-}
-
-// Next states across special_edges, filtered on a subset of
-// @enclosed_non_terminals.
-// Map(TargetState -> Pair(1. SourceState
-//                         2. ent on which this transition is taken))
-NFAStateMap<std::pair<NFAState, int>> CurrentState::SpecialNextStates(
-      Alphabet alphabet,
-      const AParseMachine& machine,
-      const std::unordered_set<int>& enclosed_non_terminals) const {
-  NFAStateMap<std::pair<NFAState, int>> output;
-  for (auto& s : nfa_states) {
-    for (auto ent : enclosed_non_terminals) {
-      auto next_states = machine.GetSpecialNextStates(s, alphabet, ent);
-      for (auto& s2 : next_states) {
-        output[s2] = make_pair(s, ent);
-      }
-    }
-  }
-  return output;
-}
-
-std::pair<StackOperation::OperationType, unordered_map<int, NFAState>>
-CurrentState::NextStackOps(
-      Alphabet alphabet,
-      const AParseMachine& machine) const {
-  std::unordered_map<int, NFAState> source_state_map;
-  auto op_type = StackOperation::NOP;
-  for (auto& s : nfa_states) {
-    auto stack_ops = machine.GetNextStackOps(s, alphabet);
-    for (auto& item : stack_ops) {
-      source_state_map.insert({item.enclosed_non_terminal, s});
-      op_type = item.type;
-    }
-  }
-  return make_pair(op_type, source_state_map);
-}
-
-bool CurrentState::IsFinal(const AParseMachine& machine) const {
-  for (auto& s : nfa_states) {
-    if (machine.IsFinalState(s)) {
-      return true;
-    }
-  }
-  return false;
-}
 
 CoreParser::CoreParser(const qk::AbstractType* machine) {
   this->SetAParseMachine(machine);
 }
 
+CoreParser::CoreParser(const qk::AbstractType* machine,
+                       TransitionCache* cache) {
+  this->SetAParseMachine(machine, cache);
+}
+
 // Is Idempotent ? : Yes
 void CoreParser::SetAParseMachine(const qk::AbstractType* machine) {
   APARSE_ASSERT(machine != nullptr);
+  own_cache = std::make_shared<TransitionCache>(
+                  static_cast<const AParseMachine*>(machine));
+  this->SetAParseMachine(machine, own_cache.get());
+}
+
+// Is Idempotent ? : Yes
+void CoreParser::SetAParseMachine(const qk::AbstractType* machine,
+                                  TransitionCache* cache) {
+  APARSE_ASSERT(machine != nullptr && cache != nullptr);
   this->machine = static_cast<const AParseMachine*>(machine);
   APARSE_ASSERT(this->machine->initialized);
+  if (cache != own_cache.get()) {
+    own_cache.reset();
+  }
+  this->cache = cache;
   this->Reset();
 }
 
-void StackFrame::DebugStream(qk::DebugStream& ds) const {
+void CoreParser::StackFrame::DebugStream(qk::DebugStream& ds) const {
   ds << "alphabet = " << alphabet << "\n"
-     << "nfa_states = " << nfa_states;
-}
-
-void CurrentState::DebugStream(qk::DebugStream& ds) const {
-  ds << nfa_states;
+     << "states = " << states->states;
 }
 
 // deprecated method.
@@ -106,35 +59,31 @@ unordered_set<Alphabet> CoreParser::PossibleAlphabets(int k) const {
 
 unordered_set<Alphabet> CoreParser::PossibleAlphabets() const {
   unordered_set<Alphabet> output;
-  for (auto& state : current_state.nfa_states) {
-    auto alphabets = machine->PossibleAlphabets(state);
-    qk::InsertToSet(alphabets, &output);
+  for (StateId s : current_states->states) {
+    for (auto& item : machine->interned_edges[s]) {
+      output.insert(item.first);
+    }
   }
   return output;
 }
 
-void CoreParser::BackTracker::DebugStream(qk::DebugStream& ds) const {
-  ds << "nfa_states_map = " << nfa_states_map << "\n"
-     << "pull_op_map = " << pull_op_map;
-}
-
-
 void CoreParser::DebugStream(qk::DebugStream& ds) const {
-  ds << "current_state = " << current_state << "\n"
-     << "stack = " << stack
-     << "\n"
-     << "back_tracker = " << back_tracker << "\n"
+  ds << "current_states = " << current_states->states << "\n"
+     << "stack = " << stack << "\n"
      << "is_valid_path_so_far = " << is_valid_path_so_far;
 }
 
 void CoreParser::Reset() {
   is_valid_path_so_far = true;
-  current_state = CurrentState({machine->start_state});
+  if (generation == nullptr || generation->id != cache->GenerationId()) {
+    generation = cache->CurrentGeneration();
+  }
+  current_states = generation->start_states;
   stack.clear();
-  stack_op_list.clear();
   stream.clear();
-  back_tracker.nfa_states_map.clear();
-  back_tracker.pull_op_map.clear();
+  transition_runs.clear();
+  back_links.clear();
+  last_transition = nullptr;
   // static_assert(sizeof(*this) == 216, "Update CoreParser::Reset method");
 }
 
@@ -187,54 +136,62 @@ bool CoreParser::CanFeed(Alphabet alphabet) const {
   APARSE_ASSERT(false, "ToDo(Mohit): Implement it");
 }
 
+void CoreParser::Migrate() {
+  vector<const StateSet*> state_sets = {current_states};
+  for (auto& frame : stack) {
+    state_sets.push_back(frame.states);
+  }
+  cache->Migrate(&state_sets, &generation);
+  last_transition = nullptr;
+  current_states = state_sets[0];
+  for (size_t i = 0; i < stack.size(); i++) {
+    stack[i].states = state_sets[i + 1];
+  }
+}
+
 bool CoreParser::Feed(Alphabet alphabet) {
   if (not is_valid_path_so_far) return false;
-  auto stack_op = current_state.NextStackOps(alphabet, *machine);
-  int feed_index = stream.size();
-  if (stack_op.first == StackOperation::PUSH) {
-    stack.emplace_back(alphabet, current_state.nfa_states);
-    current_state.nfa_states.clear();
-    for (auto& x : stack_op.second) {
-      current_state.nfa_states.insert(
-          machine->enclosed_subnfa_map.at(x.first).start_state);
-    }
-  } else if (stack_op.first == StackOperation::POP) {
-    APARSE_ASSERT(stack.size() > 0);
-    auto& stack_frame = stack.back();
-    std::unordered_set<int> enclosed_non_terminals;
-    qk::STLGetKeys(stack_op.second, &enclosed_non_terminals);
-    auto next_states_map = CurrentState(stack_frame.nfa_states)
-                              .SpecialNextStates(stack_frame.alphabet,
-                                                 *machine,
-                                                 enclosed_non_terminals);
-    auto& back_track_info = back_tracker.pull_op_map[feed_index];
-    for (auto& item : next_states_map) {
-      back_track_info[item.first] =
-          make_tuple(item.second.first,
-          item.second.second,
-          stack_op.second.at(item.second.second));
+  const Transition* transition;
+  while (true) {
+    const StateSet* frame_states = nullptr;
+    Alphabet frame_alphabet = 0;
+    if (not stack.empty()) {
+      frame_states = stack.back().states;
+      frame_alphabet = stack.back().alphabet;
     }
-    current_state.nfa_states.clear();
-    qk::STLGetKeys(next_states_map, &current_state.nfa_states);
+    transition = cache->Next(*current_states, alphabet, frame_states,
+                             frame_alphabet);
+    if (transition != nullptr) break;
+    // The cache is flushed.
+    Migrate();
+  }
+  if (transition->next_states == nullptr) {
+    is_valid_path_so_far = false;
+    return false;
+  }
+  if (transition->type == StackOperation::PUSH) {
+    stack.push_back(StackFrame{alphabet, current_states});
+  } else if (transition->type == StackOperation::POP) {
     stack.pop_back();
-  } else {
-    auto next_states_map = current_state.NextStatesMap(alphabet, *machine);
-    if (next_states_map.size() > 0) {
-      current_state.nfa_states.clear();
-      back_tracker.nfa_states_map[feed_index] = next_states_map;
-      qk::STLGetKeys(next_states_map, &current_state.nfa_states);
-    } else {
-      is_valid_path_so_far = false;
-      return false;
-    }
   }
-  stack_op_list.push_back(stack_op.first);
+  current_states = transition->next_states;
   stream.push_back(alphabet);
+  if (transition == last_transition) {
+    transition_runs.back().length++;
+    return true;
+  }
+  last_transition = transition;
+  transition_runs.push_back(TransitionRun{transition->type,
+                                          static_cast<Offset>(
+                                              back_links.size()),
+                                          1});
+  back_links.insert(back_links.end(), transition->back_links.begin(),
+                    transition->back_links.end());
   return true;
 }
 
 bool CoreParser::IsFinal() const {
-  return is_valid_path_so_far && current_state.IsFinal(*machine);
+  return is_valid_path_so_far && current_states->is_final;
 }
 
 void CoreParser::ParseOrDie(CoreParseNode* output) {
@@ -253,7 +210,7 @@ bool CoreParser::Parse(CoreParseNode* output, Error* error) {
   return true;
 }
 
-namespace {
+namespace helpers {
 
 // Given a stream of '(' and ')'  [eg: "()()()(())"], it constructs the tree.
 void ConstructTree(const vector<ParsingStream>& parsing_stream,
@@ -262,7 +219,7 @@ void ConstructTree(const vector<ParsingStream>& parsing_stream,
   output->start = 0;
   output->end = parsing_stream.size() - 1;
   branching_stack.push_back(output);
-  for (int i=0; i < parsing_stream.size(); i++) {
+  for (Offset i = 0; i < parsing_stream.size(); i++) {
     for (auto& ps : parsing_stream[i]) {
       if (ps.first == AParseMachine::BRANCH_START_MARKER) {
         branching_stack.back()->children.push_back(
@@ -279,62 +236,70 @@ void ConstructTree(const vector<ParsingStream>& parsing_stream,
   APARSE_ASSERT(output->children.size() > 0);
 }
 
-}  // namespace
+}  // namespace helpers
 
 
+// The states are tracked by their index in the StateSet they belong to.
 bool CoreParser::Parse(CoreParseNode* output) {
-  NFAState final_state;
-  bool has_final_state = false;
-  for (auto& s : current_state.nfa_states) {
-    if (machine->IsFinalState(s)) {
-      final_state = s;
-      has_final_state = true;
-      break;
-    }
-  }
-  if (not has_final_state) {
+  auto final_state = std::find_if(current_states->states.begin(),
+                                  current_states->states.end(),
+                                  [&](StateId s) {
+                                    return machine->is_final_interned_state[s];
+                                  });
+  if (final_state == current_states->states.end()) {
     return false;
   }
+  auto& states = machine->interned_states;
   vector<AParseMachine::ParsingStream> parsing_stream(1+stream.size());
-  parsing_stream[stream.size()] = machine->final_states.at(final_state);
-  NFAState cur = final_state;
-  vector<std::tuple<NFAState, int, NFAState>> construction_stack;
-  for (int i = static_cast<int>(stream.size()) - 1; i >= 0; i--) {
-    auto stack_op = stack_op_list.at(i);
-    switch (stack_op) {
+  parsing_stream[stream.size()] = machine->final_states.at(
+                                      states[*final_state]);
+  uint32_t cur = final_state - current_states->states.begin();
+  // Back-pointers of the 'POP' stack operations whose 'PUSH' is not reached
+  // yet.
+  vector<const BackLink*> construction_stack;
+  // `transition_runs[run]` covers the last `run_remaining` feed_indexes not
+  // visited yet.
+  size_t run = transition_runs.size();
+  Offset run_remaining = 0;
+  for (Offset i = static_cast<Offset>(stream.size()) - 1; i >= 0; i--) {
+    if (run_remaining == 0) {
+      run--;
+      run_remaining = transition_runs[run].length;
+    }
+    run_remaining--;
+    const BackLink* run_back_links = back_links.data() +
+                                     transition_runs[run].back_links;
+    Alphabet a = stream[i];
+    switch (transition_runs[run].type) {
       case StackOperation::PUSH: {
-        auto& tmp = construction_stack.back();
-        machine->GetSpecialParsingStream(std::get<0>(tmp),
-                                         stream.at(i),
-                                         std::get<1>(tmp),
-                                         std::get<2>(tmp),
-                                         &parsing_stream[i]);
-        cur = std::get<0>(tmp);
+        auto link = construction_stack.back();
+        auto edges = machine->FindEdges(link->source, a);
+        parsing_stream[i] = edges->special_parsing_streams[link->special_edges]
+                                                          [link->edge];
+        cur = link->source_index;
         construction_stack.pop_back();
         break;
       }
       case StackOperation::POP: {
-        auto& tmp = back_tracker.pull_op_map.at(i).at(cur);
-        construction_stack.push_back(make_tuple(std::get<0>(tmp),
-                                                std::get<1>(tmp), cur));
-        cur = std::get<2>(tmp);
+        auto& link = run_back_links[cur];
+        construction_stack.push_back(&link);
+        cur = link.enclosed_source_index;
         parsing_stream[i] = machine->enclosed_subnfa_map.at(
-                                    std::get<1>(tmp)).final_states.at(cur);
+                                link.enclosed_non_terminal).final_states.at(
+                                    states[link.enclosed_source]);
         break;
       }
       case StackOperation::NOP: {
-        auto new_cur = back_tracker.nfa_states_map.at(i).at(cur);
-        machine->GetParsingStream(new_cur,
-                                  stream.at(i),
-                                  cur,
-                                  &parsing_stream[i]);
-        cur = new_cur;
+        auto& link = run_back_links[cur];
+        parsing_stream[i] = machine->FindEdges(link.source, a)
+                                ->parsing_streams[link.edge];
+        cur = link.source_index;
         break;
       }
       default: assert(false);
     }
   }
-  ConstructTree(parsing_stream, output);
+  helpers::ConstructTree(parsing_stream, output);
   return true;
 }
 
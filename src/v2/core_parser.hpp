@@ -4,57 +4,32 @@
 #ifndef APARSE_SRC_V2_CORE_PARSER_HPP_
 #define APARSE_SRC_V2_CORE_PARSER_HPP_
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
-#include <tuple>
 
-#include <quick/unordered_set.hpp>
 #include <quick/debug_stream_decl.hpp>
 
 #include "aparse/error.hpp"
 #include "src/abstract_core_parser.hpp"
 #include "src/v2/aparse_machine.hpp"
+#include "src/v2/transition_cache.hpp"
 
 namespace aparse {
 namespace v2 {
 
-struct StackFrame {
-  using NFAState = AParseMachine::NFAState;
-  using NFAStateSet = qk::unordered_set<NFAState>;
-  StackFrame() = default;
-  StackFrame(Alphabet a, const NFAStateSet& s): alphabet(a), nfa_states(s) {}
-  void DebugStream(qk::DebugStream& ds) const;  // NOLINT
-  Alphabet alphabet;
-  NFAStateSet nfa_states;
-};
+namespace helpers {
 
-struct CurrentState {
-  using NFAState = AParseMachine::NFAState;
-  using StackOperation = AParseMachine::StackOperation;
-  using NFAStateSet = qk::unordered_set<NFAState>;
-  template<typename T> using NFAStateMap = qk::unordered_map<NFAState, T>;
-  CurrentState() = default;
-  explicit CurrentState(const NFAStateSet& nfa_states)
-  : nfa_states(nfa_states) {}
-  NFAStateMap<NFAState> NextStatesMap(Alphabet alphabet,
-                                      const AParseMachine& machine) const;
-  std::pair<StackOperation::OperationType,
-            unordered_map<int, NFAState>>
-  NextStackOps(Alphabet alphabet, const AParseMachine& machine) const;
-  NFAStateMap<std::pair<NFAState, int>> SpecialNextStates(
-      Alphabet alphabet,
-      const AParseMachine& machine,
-      const std::unordered_set<int>& enclosed_non_terminals) const;
-
-  bool IsFinal(const AParseMachine& machine) const;
-  void DebugStream(qk::DebugStream& ds) const;  // NOLINT
-
-  NFAStateSet nfa_states;
-};
+/** Construct the parse tree from the ParsingStreams of every feed_index, and
+ *  of the final state. */
+void ConstructTree(const vector<AParseMachine::ParsingStream>& parsing_stream,
+                   CoreParseNode* output);
 
+}  // namespace helpers
 
 /** CoreParser the the main Parser, which parse a string and create ParseTree.
  *  CoreParser stores the const-reference of AParseMachine. Hence
@@ -67,7 +42,12 @@ class CoreParser : public AbstractCoreParser {
  public:
   CoreParser() = default;
   explicit CoreParser(const qk::AbstractType* machine);
+  CoreParser(const qk::AbstractType* machine, TransitionCache* cache);
   void SetAParseMachine(const qk::AbstractType* machine);
+  /** Use @cache, shared with other CoreParsers, instead of a private one.
+   *  It must be built for the same @machine. */
+  void SetAParseMachine(const qk::AbstractType* machine,
+                        TransitionCache* cache);
 
   bool Parse(CoreParseNode* output);
   void ParseOrDie(CoreParseNode* output);
@@ -87,32 +67,51 @@ class CoreParser : public AbstractCoreParser {
   unordered_set<Alphabet> PossibleAlphabets() const;
   unordered_set<Alphabet> PossibleAlphabets(int k) const;  // return k only.
   void DebugStream(qk::DebugStream&) const;  // NOLINT
-  using NFAState = AParseMachine::NFAState;
-  template<typename T> using NFAStateMap = qk::unordered_map<NFAState, T>;
-  struct BackTracker {
+  using StateId = AParseMachine::StateId;
+  using StateSet = TransitionCache::StateSet;
+  using Transition = TransitionCache::Transition;
+  using BackLink = TransitionCache::BackLink;
+  struct StackFrame {
     void DebugStream(qk::DebugStream& ds) const;  // NOLINT
-    // feed_index -> Map(current_states -> their previous state)
-    std::unordered_map<int, NFAStateMap<NFAState>> nfa_states_map;
-    // This map is stored only for 'POP' stack operations.
-    // feed_index -> Map(current_state ->
-    //     Tuple(1. It's previous state among the states pushed in stack
-    //           2. Recognized enclosed_non_terminal,
-    //           3. It's previous state in enclose_nfa))
-    std::unordered_map<int, NFAStateMap<std::tuple<NFAState,
-                                                   int,
-                                                   NFAState>>> pull_op_map;
+    Alphabet alphabet;
+    const StateSet* states;
   };
 
  private:
   using StackOperation = AParseMachine::StackOperation;
   const AParseMachine* machine = nullptr;
+  TransitionCache* cache = nullptr;
+  // Used if no cache is supplied in SetAParseMachine.
+  std::shared_ptr<TransitionCache> own_cache;
+  // Generation of the cache owning `current_states` and the `stack`.
+  std::shared_ptr<const TransitionCache::Generation> generation;
   // Invariant: Update the default values of these members in Reset method.
   bool is_valid_path_so_far = true;
-  CurrentState current_state;
+  const StateSet* current_states = nullptr;
   vector<StackFrame> stack;
   vector<Alphabet> stream;
-  vector<StackOperation::OperationType> stack_op_list;
-  BackTracker back_tracker;
+  // Run-length encoded log of the transitions taken at every feed_index,
+  // appended by Feed and walked backwards by Parse. Repetitions of the same
+  // transition (e.g. in a list of similar tokens) take a single run. The
+  // back-pointers of a run are copied from its transition into the
+  // `back_links` arena, so that the log doesn't hold the transitions of the
+  // cache.
+  struct TransitionRun {
+    StackOperation::OperationType type;
+    // back_links[this->back_links + j] is the back-pointer of the j-th state
+    // reached.
+    Offset back_links;
+    Offset length;
+  };
+  vector<TransitionRun> transition_runs;
+  vector<BackLink> back_links;
+  // Transition of the last run. Valid until the parser is migrated to
+  // another generation of the cache.
+  const Transition* last_transition = nullptr;
+
+  /** Move `current_states` and the `stack` to the current generation of the
+   *  cache. */
+  void Migrate();
 };
 
 }  // namespace v2
@@ -1,7 +1,9 @@
 // Copyright: 2015 Mohit Saini
 // Author: Mohit Saini (mohitsaini1196@gmail.com)
 
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
 #include "quick/debug.hpp"
 #include "gtest/gtest.h"
@@ -22,6 +24,7 @@ using std::set;
 using aparse::v2::AParseMachineBuilder;
 using aparse::v2::AParseMachine;
 using aparse::v2::CoreParser;
+using aparse::v2::TransitionCache;
 using std::cout;
 using std::endl;
 using std::unordered_set;
@@ -379,3 +382,202 @@ TEST_F(CoreParserIntegrationTest, ImportExport) {
   EXPECT_EQ(m2, m22);
   EXPECT_EQ(m3, m33);
 }
+
+TEST_F(CoreParserIntegrationTest, InternedStates) {
+  AParseMachine m33;
+  m33.Import(m3.Export());
+  EXPECT_EQ(m3.interned_states, m33.interned_states);
+  EXPECT_EQ(m3.start_state, m3.interned_states[m3.interned_start_state]);
+  EXPECT_EQ(m3.interned_states.size(), m3.interned_edges.size());
+  for (AParseMachine::StateId s = 0; s < m3.interned_states.size(); s++) {
+    auto& state = m3.interned_states[s];
+    EXPECT_EQ(m3.IsFinalState(state), m3.is_final_interned_state[s]);
+    using Edges = std::pair<aparse::Alphabet, AParseMachine::InternedEdges>;
+    EXPECT_TRUE(std::is_sorted(m3.interned_edges[s].begin(),
+                               m3.interned_edges[s].end(),
+                               [](const Edges& x, const Edges& y) {
+                                 return x.first < y.first;
+                               }));
+    size_t num_edges = 0;
+    for (uint32_t a = 0; a < m3.num_interned_alphabets; a++) {
+      num_edges += (m3.FindEdges(s, a) != nullptr);
+    }
+    EXPECT_EQ(m3.interned_edges[s].size(), num_edges);
+    EXPECT_EQ(nullptr, m3.FindEdges(s, m3.num_interned_alphabets));
+    EXPECT_EQ(nullptr, m3.FindEdges(s, -1));
+    for (auto& item : m3.interned_edges[s]) {
+      EXPECT_EQ(&item.second, m3.FindEdges(s, item.first));
+      AParseMachine::NFAStateSet next_states;
+      for (auto t : item.second.next_states) {
+        next_states.insert(m3.interned_states[t]);
+      }
+      auto expected = m3.GetNextStates(state, item.first);
+      EXPECT_EQ(expected.size(), next_states.size());
+      for (auto& t : expected) {
+        EXPECT_EQ(1, next_states.count(t));
+      }
+      for (auto t : item.second.next_states) {
+        AParseMachine::ParsingStream parsing_stream;
+        m3.GetParsingStream(state, item.first, m3.interned_states[t],
+                            &parsing_stream);
+        EXPECT_EQ(parsing_stream,
+                  m3.GetInternedParsingStream(s, item.first, t));
+      }
+      for (auto& special : item.second.special_next_states) {
+        EXPECT_EQ(m3.GetSpecialNextStates(state, item.first, special.first)
+                      .size(),
+                  special.second.size());
+        for (auto t : special.second) {
+          AParseMachine::ParsingStream parsing_stream;
+          m3.GetSpecialParsingStream(state, item.first, special.first,
+                                     m3.interned_states[t], &parsing_stream);
+          EXPECT_EQ(parsing_stream,
+                    m3.GetInternedSpecialParsingStream(s, item.first,
+                                                       special.first, t));
+        }
+      }
+    }
+  }
+}
+
+// Long runs of the same transition, while pushing and popping.
+TEST_F(CoreParserIntegrationTest, RepeatedTransitions) {
+  const int depth = 1000;
+  CoreParser parser(&m1);
+  for (int j = 0; j < 2; j++) {
+    // ((( ... ))) ((( ... )))
+    EXPECT_TRUE(parser.Feed(vector<int>(depth, 0)));
+    EXPECT_TRUE(parser.Feed(vector<int>(depth, 1)));
+  }
+  CoreParseNode tree;
+  EXPECT_TRUE(parser.Parse(&tree));
+  ASSERT_EQ(1, tree.children.size());
+  ASSERT_EQ(2, tree.children[0].children.size());
+  for (int j = 0; j < 2; j++) {
+    const CoreParseNode* node = &tree.children[0].children[j];
+    for (int k = 0; k < depth; k++) {
+      EXPECT_EQ(j*2*depth + k + 1, node->start);
+      EXPECT_EQ((j+1)*2*depth - 1 - k, node->end);
+      if (k + 1 < depth) {
+        ASSERT_EQ(1, node->children.size());
+        node = &node->children[0];
+      }
+    }
+    EXPECT_EQ(0, node->children.size());
+  }
+}
+
+// The back-pointers are parallel to the states reached, and refer to the
+// previous states by their index.
+TEST_F(CoreParserIntegrationTest, TransitionCacheBackLinks) {
+  // [BOOL, NUM, {STRING: [NULL, {STRING: NUM}], STRING: BOOL}]
+  vector<int> stream = {0, 8, 4, 6, 4, 2, 7, 5, 0, 9, 4, 2, 7, 5, 6, 3, 1, 4,
+                        7, 5, 8, 3, 1};
+  TransitionCache cache(&m3);
+  auto generation = cache.CurrentGeneration();
+  const TransitionCache::StateSet* states = generation->start_states;
+  vector<std::pair<aparse::Alphabet, const TransitionCache::StateSet*>> stack;
+  for (int a : stream) {
+    auto frame_states = stack.empty() ? nullptr : stack.back().second;
+    auto frame_alphabet = stack.empty() ? 0 : stack.back().first;
+    auto transition = cache.Next(*states, a, frame_states, frame_alphabet);
+    ASSERT_NE(nullptr, transition);
+    ASSERT_NE(nullptr, transition->next_states);
+    auto& next_states = transition->next_states->states;
+    EXPECT_TRUE(std::is_sorted(next_states.begin(), next_states.end()));
+    using StackOperation = AParseMachine::StackOperation;
+    if (transition->type == StackOperation::PUSH) {
+      EXPECT_TRUE(transition->back_links.empty());
+      stack.emplace_back(a, states);
+    } else {
+      ASSERT_EQ(next_states.size(), transition->back_links.size());
+      for (size_t j = 0; j < next_states.size(); j++) {
+        auto& link = transition->back_links[j];
+        if (transition->type == StackOperation::NOP) {
+          EXPECT_EQ(link.source, states->states[link.source_index]);
+          EXPECT_EQ(next_states[j],
+                    m3.FindEdges(link.source, a)->next_states[link.edge]);
+        } else {
+          EXPECT_EQ(link.source, frame_states->states[link.source_index]);
+          EXPECT_EQ(link.enclosed_source,
+                    states->states[link.enclosed_source_index]);
+          auto& item = m3.FindEdges(link.source, frame_alphabet)
+                           ->special_next_states[link.special_edges];
+          EXPECT_EQ(link.enclosed_non_terminal, item.first);
+          EXPECT_EQ(next_states[j], item.second[link.edge]);
+        }
+      }
+      if (transition->type == StackOperation::POP) {
+        stack.pop_back();
+      }
+    }
+    states = transition->next_states;
+  }
+  EXPECT_TRUE(states->is_final);
+}
+
+TEST_F(CoreParserIntegrationTest, SharedTransitionCache) {
+  // [BOOL, NUM, {STRING: [NULL, {STRING: NUM}], STRING: BOOL}]
+  vector<int> stream = {0, 8, 4, 6, 4, 2, 7, 5, 0, 9, 4, 2, 7, 5, 6, 3, 1, 4,
+                        7, 5, 8, 3, 1};
+  CoreParseNode expected;
+  {
+    CoreParser parser(&m3);
+    EXPECT_TRUE(parser.Feed(stream));
+    EXPECT_TRUE(parser.Parse(&expected));
+  }
+  // A tiny cache is flushed several times during a single parse.
+  TransitionCache small_cache(&m3, 4);
+  CoreParser p1(&m3, &small_cache), p2(&m3, &small_cache);
+  for (int i = 0; i < stream.size(); i++) {
+    EXPECT_TRUE(p1.Feed(stream[i]));
+    EXPECT_TRUE(p2.Feed(stream[i]));
+    EXPECT_LE(small_cache.size(), 4);
+  }
+  CoreParseNode tree1, tree2;
+  EXPECT_TRUE(p1.Parse(&tree1));
+  EXPECT_TRUE(p2.Parse(&tree2));
+  EXPECT_EQ(expected, tree1);
+  EXPECT_EQ(expected, tree2);
+  // Concurrent parsers sharing a cache.
+  TransitionCache cache(&m3);
+  vector<std::thread> threads;
+  vector<int> num_failures(4, 0);
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      CoreParser parser(&m3, &cache);
+      for (int i = 0; i < 100; i++) {
+        parser.Reset();
+        CoreParseNode tree;
+        if (not parser.Feed(stream) || not parser.Parse(&tree) ||
+            not (tree == expected)) {
+          num_failures[t]++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_failures, vector<int>(4, 0));
+  // Concurrent parsers sharing a cache, flushed while they are parsing.
+  threads.clear();
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      CoreParser parser(&m3, &small_cache);
+      for (int i = 0; i < 100; i++) {
+        parser.Reset();
+        CoreParseNode tree;
+        if (not parser.Feed(stream) || not parser.Parse(&tree) ||
+            not (tree == expected)) {
+          num_failures[t]++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_failures, vector<int>(4, 0));
+  EXPECT_LE(small_cache.size(), 4);
+}
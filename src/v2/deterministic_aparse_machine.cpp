@@ -0,0 +1,349 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "src/v2/deterministic_aparse_machine.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "quick/stl_utils.hpp"
+
+namespace aparse {
+namespace v2 {
+
+constexpr uint32_t DeterministicAParseMachine::kNoState;
+
+void DeterministicAParseMachine::Transition::Serialize(
+    qk::OByteStream& bs) const {
+  bs << type << target << frame << back_links << pop_row;
+}
+
+void DeterministicAParseMachine::Transition::Deserialize(
+    qk::IByteStream& bs) {
+  bs >> type >> target >> frame >> back_links >> pop_row;
+}
+
+bool DeterministicAParseMachine::Transition::operator==(
+    const Transition& o) const {
+  return (type == o.type && target == o.target && frame == o.frame &&
+          back_links == o.back_links && pop_row == o.pop_row);
+}
+
+void DeterministicAParseMachine::BackLink::Serialize(
+    qk::OByteStream& bs) const {
+  bs << source << edge;
+}
+
+void DeterministicAParseMachine::BackLink::Deserialize(qk::IByteStream& bs) {
+  bs >> source >> edge;
+}
+
+bool DeterministicAParseMachine::BackLink::operator==(
+    const BackLink& o) const {
+  return (source == o.source && edge == o.edge);
+}
+
+void DeterministicAParseMachine::PopBackLink::Serialize(
+    qk::OByteStream& bs) const {
+  bs << frame_source << special_edges << edge << source;
+}
+
+void DeterministicAParseMachine::PopBackLink::Deserialize(
+    qk::IByteStream& bs) {
+  bs >> frame_source >> special_edges >> edge >> source;
+}
+
+bool DeterministicAParseMachine::PopBackLink::operator==(
+    const PopBackLink& o) const {
+  return (frame_source == o.frame_source &&
+          special_edges == o.special_edges && edge == o.edge &&
+          source == o.source);
+}
+
+void DeterministicAParseMachine::PopEntry::Serialize(
+    qk::OByteStream& bs) const {
+  bs << target << back_links;
+}
+
+void DeterministicAParseMachine::PopEntry::Deserialize(qk::IByteStream& bs) {
+  bs >> target >> back_links;
+}
+
+bool DeterministicAParseMachine::PopEntry::operator==(
+    const PopEntry& o) const {
+  return (target == o.target && back_links == o.back_links);
+}
+
+// Subset construction over the pairs (DFA state, frame on top of stack).
+// The target of a 'POP' depends on the frame on top of the stack, and the
+// pair reached after it has the frame below it on top of the stack. A frame
+// can be pushed over different frames, hence the frames below a frame
+// (`parent_frames`) and the DFA states reached by popping a frame
+// (`popped_states`) are accumulated until a fixed point is reached.
+// Along with a target DFA state, the first predecessor of each of its NFA
+// states, in the sorted order of the source NFA states, is recorded
+// (`back_links`, `pop_back_links`).
+void DeterministicAParseMachine::Build(const AParseMachine& nfa_machine) {
+  APARSE_ASSERT(nfa_machine.initialized);
+  this->nfa_machine = nfa_machine;
+  states.clear();
+  is_final_state.clear();
+  frames.clear();
+  pop_table.clear();
+  back_links.clear();
+  pop_back_links.clear();
+  num_alphabets = nfa_machine.num_interned_alphabets;
+  constexpr uint32_t kNoFrame = kNoState;
+  std::map<std::vector<StateId>, uint32_t> state_ids;
+  std::map<std::pair<uint32_t, Alphabet>, uint32_t> frame_ids;
+  std::map<std::pair<uint32_t, Alphabet>, Transition> transitions;
+  // Map(Pair(row of a 'POP' transition, frame) -> PopEntry)
+  std::map<std::pair<uint32_t, uint32_t>, PopEntry> pop_entries;
+  uint32_t num_pop_rows = 0;
+  std::vector<std::set<uint32_t>> parent_frames, popped_states;
+  std::set<std::pair<uint32_t, uint32_t>> visited;
+  std::vector<std::pair<uint32_t, uint32_t>> queue;
+  auto lStateId = [&](std::vector<StateId>* subset) {
+    std::sort(subset->begin(), subset->end());
+    subset->erase(std::unique(subset->begin(), subset->end()), subset->end());
+    auto it = state_ids.find(*subset);
+    if (it != state_ids.end()) {
+      return it->second;
+    }
+    uint32_t id = states.size();
+    state_ids.emplace(*subset, id);
+    states.push_back(*subset);
+    bool is_final = false;
+    for (StateId s : *subset) {
+      is_final = is_final || nfa_machine.is_final_interned_state[s];
+    }
+    is_final_state.push_back(is_final);
+    return id;
+  };
+  auto lFrameId = [&](uint32_t state, Alphabet a) {
+    auto it = frame_ids.find({state, a});
+    if (it != frame_ids.end()) {
+      return it->second;
+    }
+    uint32_t id = frames.size();
+    frame_ids.emplace(std::make_pair(state, a), id);
+    frames.emplace_back(state, a);
+    parent_frames.emplace_back();
+    popped_states.emplace_back();
+    return id;
+  };
+  // Index of the NFA state @s in the DFA state @state.
+  auto lIndex = [&](uint32_t state, StateId s) {
+    auto& nfa_states = states[state];
+    return static_cast<uint32_t>(
+        std::lower_bound(nfa_states.begin(), nfa_states.end(), s) -
+        nfa_states.begin());
+  };
+  auto lVisit = [&](uint32_t state, uint32_t frame) {
+    if (visited.emplace(state, frame).second) {
+      queue.emplace_back(state, frame);
+    }
+  };
+  auto lAddParentFrame = [&](uint32_t frame, uint32_t parent) {
+    if (parent_frames[frame].insert(parent).second) {
+      for (uint32_t state : popped_states[frame]) {
+        lVisit(state, parent);
+      }
+    }
+  };
+  auto lAddPoppedState = [&](uint32_t frame, uint32_t state) {
+    if (popped_states[frame].insert(state).second) {
+      for (uint32_t parent : parent_frames[frame]) {
+        lVisit(state, parent);
+      }
+    }
+  };
+  std::vector<StateId> subset = {nfa_machine.interned_start_state};
+  start_state = lStateId(&subset);
+  lVisit(start_state, kNoFrame);
+  std::vector<std::pair<int, StateId>> sources;
+  for (size_t q = 0; q < queue.size(); q++) {
+    uint32_t state = queue[q].first, frame = queue[q].second;
+    std::set<Alphabet> alphabets;
+    for (StateId s : states[state]) {
+      for (auto& item : nfa_machine.interned_edges[s]) {
+        alphabets.insert(item.first);
+      }
+    }
+    for (Alphabet a : alphabets) {
+      auto it = transitions.find({state, a});
+      if (it == transitions.end()) {
+        // The transitions of 'NOP' and 'PUSH' don't depend on the frame.
+        Transition t;
+        t.type = nfa_machine.GetInternedStackOps(states[state], a, &sources);
+        subset.clear();
+        if (t.type == StackOperation::PUSH) {
+          for (auto& x : sources) {
+            subset.push_back(
+                nfa_machine.interned_enclosed_start_states.at(x.first));
+          }
+          t.target = lStateId(&subset);
+          t.frame = lFrameId(state, a);
+        } else if (t.type == StackOperation::NOP) {
+          for (StateId s : states[state]) {
+            auto edges = nfa_machine.FindEdges(s, a);
+            if (edges != nullptr) {
+              subset.insert(subset.end(), edges->next_states.begin(),
+                            edges->next_states.end());
+            }
+          }
+          if (not subset.empty()) {
+            t.target = lStateId(&subset);
+            t.back_links = back_links.size();
+            std::vector<uint8_t> linked(states[t.target].size(), false);
+            back_links.resize(back_links.size() + linked.size());
+            for (uint32_t k = 0; k < states[state].size(); k++) {
+              auto edges = nfa_machine.FindEdges(states[state][k], a);
+              if (edges == nullptr) continue;
+              for (uint32_t e = 0; e < edges->next_states.size(); e++) {
+                uint32_t j = lIndex(t.target, edges->next_states[e]);
+                if (not linked[j]) {
+                  linked[j] = true;
+                  back_links[t.back_links + j].source = k;
+                  back_links[t.back_links + j].edge = e;
+                }
+              }
+            }
+          }
+        } else {
+          t.pop_row = num_pop_rows++;
+        }
+        it = transitions.emplace(std::make_pair(state, a), t).first;
+      }
+      const Transition t = it->second;
+      if (t.type == StackOperation::PUSH) {
+        lVisit(t.target, t.frame);
+        lAddParentFrame(t.frame, frame);
+      } else if (t.type == StackOperation::NOP) {
+        if (t.target != kNoState) {
+          lVisit(t.target, frame);
+        }
+      } else if (frame != kNoFrame) {
+        nfa_machine.GetInternedStackOps(states[state], a, &sources);
+        auto stack_frame = frames[frame];
+        subset.clear();
+        for (StateId s : states[stack_frame.first]) {
+          auto edges = nfa_machine.FindEdges(s, stack_frame.second);
+          if (edges == nullptr) continue;
+          for (auto& item : edges->special_next_states) {
+            for (auto& x : sources) {
+              if (x.first == item.first) {
+                subset.insert(subset.end(), item.second.begin(),
+                              item.second.end());
+              }
+            }
+          }
+        }
+        if (not subset.empty()) {
+          PopEntry entry;
+          entry.target = lStateId(&subset);
+          entry.back_links = pop_back_links.size();
+          std::vector<uint8_t> linked(states[entry.target].size(), false);
+          pop_back_links.resize(pop_back_links.size() + linked.size());
+          auto& frame_states = states[stack_frame.first];
+          for (uint32_t k = 0; k < frame_states.size(); k++) {
+            auto edges = nfa_machine.FindEdges(frame_states[k],
+                                               stack_frame.second);
+            if (edges == nullptr) continue;
+            for (uint32_t i = 0; i < edges->special_next_states.size(); i++) {
+              auto& item = edges->special_next_states[i];
+              auto x = std::find_if(sources.begin(), sources.end(),
+                                    [&](const std::pair<int, StateId>& x) {
+                                      return x.first == item.first;
+                                    });
+              if (x == sources.end()) continue;
+              for (uint32_t e = 0; e < item.second.size(); e++) {
+                uint32_t j = lIndex(entry.target, item.second[e]);
+                if (not linked[j]) {
+                  linked[j] = true;
+                  auto& link = pop_back_links[entry.back_links + j];
+                  link.frame_source = k;
+                  link.special_edges = i;
+                  link.edge = e;
+                  link.source = lIndex(state, x->second);
+                }
+              }
+            }
+          }
+          pop_entries[std::make_pair(t.pop_row, frame)] = entry;
+          lAddPoppedState(frame, entry.target);
+        }
+      }
+    }
+  }
+  transition_table.assign(states.size() * num_alphabets, Transition());
+  for (auto& item : transitions) {
+    transition_table[item.first.first * num_alphabets + item.first.second] =
+        item.second;
+  }
+  pop_table.assign(static_cast<size_t>(num_pop_rows) * frames.size(),
+                   PopEntry());
+  for (auto& item : pop_entries) {
+    pop_table[static_cast<size_t>(item.first.first) * frames.size() +
+              item.first.second] = item.second;
+  }
+  initialized = true;
+}
+
+void DeterministicAParseMachine::Serialize(qk::OByteStream& bs) const {
+  bs << nfa_machine << num_alphabets << start_state << states
+     << is_final_state << transition_table << frames << pop_table
+     << back_links << pop_back_links;
+}
+
+void DeterministicAParseMachine::Deserialize(qk::IByteStream& bs) {
+  bs >> nfa_machine >> num_alphabets >> start_state >> states
+     >> is_final_state >> transition_table >> frames >> pop_table
+     >> back_links >> pop_back_links;
+  // `nfa_machine` is complete once deserialized.
+  nfa_machine.initialized = true;
+}
+
+bool DeterministicAParseMachine::operator==(
+    const DeterministicAParseMachine& other) const {
+  return (nfa_machine == other.nfa_machine and
+          num_alphabets == other.num_alphabets and
+          start_state == other.start_state and
+          states == other.states and
+          is_final_state == other.is_final_state and
+          transition_table == other.transition_table and
+          frames == other.frames and
+          pop_table == other.pop_table and
+          back_links == other.back_links and
+          pop_back_links == other.pop_back_links);
+}
+
+// Format Version - 2
+std::string DeterministicAParseMachine::Export() const {
+  qk::OByteStream obs;
+  uint32_t version = 2;
+  obs << version << *this;
+  return obs.str();
+}
+
+// Format Version - 2
+bool DeterministicAParseMachine::Import(
+    const std::string& serialized_machine) {
+  qk::IByteStream ibs;
+  ibs.str(serialized_machine);
+  uint32_t expected_version = 2, current_version;
+  ibs >> current_version;
+  if (current_version != expected_version) {
+    return false;
+  }
+  ibs >> *this;
+  initialized = true;
+  return true;
+}
+
+}  // namespace v2
+}  // namespace aparse
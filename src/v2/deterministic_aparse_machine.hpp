@@ -0,0 +1,143 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#ifndef APARSE_SRC_V2_DETERMINISTIC_APARSE_MACHINE_HPP_
+#define APARSE_SRC_V2_DETERMINISTIC_APARSE_MACHINE_HPP_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "quick/byte_stream.hpp"
+#include "quick/debug_stream_decl.hpp"
+#include "quick/utility.hpp"
+
+#include "aparse/common_headers.hpp"
+#include "src/v2/aparse_machine.hpp"
+
+namespace aparse {
+namespace v2 {
+
+/** AParseMachine of Parser::VERY_LOW_COMPRESSION machine type.
+ *  It's the subset construction of the interned states of `nfa_machine`:
+ *  Each DFA state is a set of NFA states, reachable together for some
+ *  prefix of the stream. The stack frames are also determinized: A frame is
+ *  a pair(DFA state, branching alphabet) pushed by a 'PUSH' stack operation.
+ *  Hence feeding an alphabet is a single lookup in the `transition_table`,
+ *  followed by a push/pop of a frame.
+ *  `nfa_machine` is kept for constructing the parse tree. */
+struct DeterministicAParseMachine : public quick::AbstractType {
+  using StateId = AParseMachine::StateId;
+  using StackOperation = AParseMachine::StackOperation;
+
+  static constexpr uint32_t kNoState = static_cast<uint32_t>(-1);
+
+  struct Transition {
+    void Serialize(quick::OByteStream&) const;  // NOLINT
+    void Deserialize(quick::IByteStream&);  // NOLINT
+    bool operator==(const Transition& o) const;
+
+    StackOperation::OperationType type = StackOperation::NOP;
+    // Next DFA state in case of 'NOP' and 'PUSH'. kNoState if the alphabet
+    // cannot be fed. Unused in case of 'POP', refer to `pop_table`.
+    uint32_t target = kNoState;
+    // Frame pushed in case of 'PUSH'.
+    uint32_t frame = 0;
+    // 'NOP': back_links[this->back_links + j] is the BackLink of the j-th
+    // NFA state of `target`.
+    uint32_t back_links = 0;
+    // 'POP': Row of this transition in `pop_table`.
+    uint32_t pop_row = 0;
+  };
+
+  /** The NFA state, and its edge, through which an NFA state of the target
+   *  of a 'NOP' transition is reached first. Used for recovering the NFA
+   *  path in DeterministicCoreParser::Parse without any search. */
+  struct BackLink {
+    void Serialize(quick::OByteStream&) const;  // NOLINT
+    void Deserialize(quick::IByteStream&);  // NOLINT
+    bool operator==(const BackLink& o) const;
+
+    // Index of the source NFA state in `states[source DFA state]`.
+    uint32_t source = 0;
+    // Index of the target NFA state in the `next_states` of the edges of
+    // the source NFA state.
+    uint32_t edge = 0;
+  };
+
+  /** Same as BackLink, for a 'POP' transition. */
+  struct PopBackLink {
+    void Serialize(quick::OByteStream&) const;  // NOLINT
+    void Deserialize(quick::IByteStream&);  // NOLINT
+    bool operator==(const PopBackLink& o) const;
+
+    // Index of the NFA state, which pushed the frame, in
+    // `states[frame's DFA state]`.
+    uint32_t frame_source = 0;
+    // Index of the enclosed-non-terminal in the `special_next_states` of the
+    // edges of that NFA state on the frame's branching alphabet.
+    uint32_t special_edges = 0;
+    // Index of the target NFA state in that list.
+    uint32_t edge = 0;
+    // Index of the final NFA state of the enclosed sub-NFA in
+    // `states[source DFA state]`.
+    uint32_t source = 0;
+  };
+
+  struct PopEntry {
+    void Serialize(quick::OByteStream&) const;  // NOLINT
+    void Deserialize(quick::IByteStream&);  // NOLINT
+    bool operator==(const PopEntry& o) const;
+
+    // Next DFA state, or kNoState if it's not possible to pop the frame.
+    uint32_t target = kNoState;
+    // pop_back_links[this->back_links + j] is the PopBackLink of the j-th
+    // NFA state of `target`.
+    uint32_t back_links = 0;
+  };
+
+  /** Build from the NFA based machine. */
+  void Build(const AParseMachine& nfa_machine);
+
+  inline const Transition* FindTransition(uint32_t state, Alphabet a) const {
+    if (a < 0 || a >= num_alphabets) {
+      return nullptr;
+    }
+    return &transition_table[state * num_alphabets + a];
+  }
+
+  /** 'POP' transition @t, when @frame is on top of the stack. */
+  inline const PopEntry& FindPopEntry(const Transition& t,
+                                      uint32_t frame) const {
+    return pop_table[static_cast<size_t>(t.pop_row) * frames.size() + frame];
+  }
+
+  void Serialize(quick::OByteStream&) const;  // NOLINT
+  void Deserialize(quick::IByteStream&);  // NOLINT
+  bool operator==(const DeterministicAParseMachine& o) const;
+  std::string Export() const;
+  bool Import(const std::string& serialized_machine);
+
+  AParseMachine nfa_machine;
+  // Alphabets are in the range [0, num_alphabets).
+  int32_t num_alphabets = 0;
+  uint32_t start_state = 0;
+  // DFA state -> sorted interned states of `nfa_machine`.
+  std::vector<std::vector<StateId>> states;
+  std::vector<uint8_t> is_final_state;
+  // transition_table[state * num_alphabets + alphabet]
+  std::vector<Transition> transition_table;
+  // frame -> Pair(DFA state, branching alphabet) pushed in stack.
+  std::vector<std::pair<uint32_t, Alphabet>> frames;
+  // pop_table[row * frames.size() + frame] is the PopEntry of the 'POP'
+  // transition having the `row`, when `frame` is on top of the stack.
+  std::vector<PopEntry> pop_table;
+  std::vector<BackLink> back_links;
+  std::vector<PopBackLink> pop_back_links;
+  bool initialized = false;
+};
+
+}  // namespace v2
+}  // namespace aparse
+
+#endif  // APARSE_SRC_V2_DETERMINISTIC_APARSE_MACHINE_HPP_
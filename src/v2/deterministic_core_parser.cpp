@@ -0,0 +1,251 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "src/v2/deterministic_core_parser.hpp"
+
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "aparse/error.hpp"
+#include "quick/debug.hpp"
+#include "src/v2/core_parser.hpp"
+
+namespace aparse {
+namespace v2 {
+
+DeterministicCoreParser::DeterministicCoreParser(
+    const qk::AbstractType* machine) {
+  this->SetAParseMachine(machine);
+}
+
+// Is Idempotent ? : Yes
+void DeterministicCoreParser::SetAParseMachine(
+    const qk::AbstractType* machine) {
+  APARSE_ASSERT(machine != nullptr);
+  this->machine = static_cast<const DeterministicAParseMachine*>(machine);
+  APARSE_ASSERT(this->machine->initialized);
+  this->Reset();
+}
+
+// deprecated method.
+unordered_set<Alphabet> DeterministicCoreParser::PossibleAlphabets(
+    int k) const {
+  return PossibleAlphabets();
+}
+
+unordered_set<Alphabet> DeterministicCoreParser::PossibleAlphabets() const {
+  unordered_set<Alphabet> output;
+  for (Alphabet a = 0; a < machine->num_alphabets; a++) {
+    if (HasTransition(a)) {
+      output.insert(a);
+    }
+  }
+  return output;
+}
+
+void DeterministicCoreParser::DebugStream(qk::DebugStream& ds) const {
+  ds << "current_state = " << current_state << "\n"
+     << "stack = " << stack << "\n"
+     << "state_trace = " << state_trace << "\n"
+     << "is_valid_path_so_far = " << is_valid_path_so_far;
+}
+
+void DeterministicCoreParser::Reset() {
+  is_valid_path_so_far = true;
+  current_state = machine->start_state;
+  stack.clear();
+  stream.clear();
+  state_trace.clear();
+}
+
+const vector<Alphabet>& DeterministicCoreParser::GetStream() const {
+  return stream;
+}
+
+bool DeterministicCoreParser::Feed(const vector<Alphabet>& stream) {
+  for (int i = 0; i < stream.size(); i++) {
+    if (not Feed(stream[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void DeterministicCoreParser::FeedOrDie(const vector<Alphabet>& stream) {
+  for (int i = 0; i < stream.size(); i++) {
+    FeedOrDie(stream[i]);
+  }
+}
+
+bool DeterministicCoreParser::Feed(const vector<Alphabet>& stream,
+                                   Error* error) {
+  for (int i = 0; i < stream.size(); i++) {
+    if (not Feed(stream[i], error))
+      return false;
+  }
+  return true;
+}
+
+void DeterministicCoreParser::FeedOrDie(Alphabet a) {
+  if (not Feed(a)) {
+    throw Error(Error::PARSING_ERROR_INVALID_TOKENS)
+                .Position({stream.size(), 1})
+                .PossibleAlphabets(PossibleAlphabets())();
+  }
+}
+
+bool DeterministicCoreParser::Feed(Alphabet alphabet, Error* error) {
+  if (not Feed(alphabet)) {
+    *error = Error(Error::PARSING_ERROR_INVALID_TOKENS)
+                .Position({stream.size(), 1})
+                .PossibleAlphabets(PossibleAlphabets())();
+    return false;
+  }
+  return true;
+}
+
+bool DeterministicCoreParser::CanFeed(Alphabet alphabet) const {
+  return is_valid_path_so_far && HasTransition(alphabet);
+}
+
+bool DeterministicCoreParser::HasTransition(Alphabet alphabet) const {
+  auto t = machine->FindTransition(current_state, alphabet);
+  if (t == nullptr) return false;
+  if (t->type == StackOperation::POP) {
+    return (not stack.empty() &&
+            machine->FindPopEntry(*t, stack.back()).target
+                != DeterministicAParseMachine::kNoState);
+  }
+  return t->target != DeterministicAParseMachine::kNoState;
+}
+
+bool DeterministicCoreParser::Feed(Alphabet alphabet) {
+  if (not is_valid_path_so_far) return false;
+  auto t = machine->FindTransition(current_state, alphabet);
+  uint32_t next_state = DeterministicAParseMachine::kNoState;
+  if (t != nullptr) {
+    if (t->type == StackOperation::POP) {
+      if (not stack.empty()) {
+        next_state = machine->FindPopEntry(*t, stack.back()).target;
+        if (next_state != DeterministicAParseMachine::kNoState) {
+          stack.pop_back();
+        }
+      }
+    } else {
+      next_state = t->target;
+      if (t->type == StackOperation::PUSH) {
+        stack.push_back(t->frame);
+      }
+    }
+  }
+  if (next_state == DeterministicAParseMachine::kNoState) {
+    is_valid_path_so_far = false;
+    return false;
+  }
+  state_trace.push_back(current_state);
+  stream.push_back(alphabet);
+  current_state = next_state;
+  return true;
+}
+
+bool DeterministicCoreParser::IsFinal() const {
+  return is_valid_path_so_far && machine->is_final_state[current_state];
+}
+
+void DeterministicCoreParser::ParseOrDie(CoreParseNode* output) {
+  if (not Parse(output)) {
+    throw Error(Error::PARSING_ERROR_INCOMPLETE_TOKENS)
+                .PossibleAlphabets(PossibleAlphabets())();
+  }
+}
+
+bool DeterministicCoreParser::Parse(CoreParseNode* output, Error* error) {
+  if (not Parse(output)) {
+    *error = Error(Error::PARSING_ERROR_INCOMPLETE_TOKENS)
+                .PossibleAlphabets(PossibleAlphabets())();
+    return false;
+  }
+  return true;
+}
+
+// Same as CoreParser::Parse, except that the back-pointers are not recorded
+// while feeding. Walking backwards, the previous NFA state is found in the
+// back-links of the transitions, recorded by DeterministicAParseMachine.
+// The NFA states are tracked by their index in the NFA states of the DFA
+// state they belong to.
+bool DeterministicCoreParser::Parse(CoreParseNode* output) {
+  if (not IsFinal()) {
+    return false;
+  }
+  auto& nfa_machine = machine->nfa_machine;
+  auto& nfa_states = nfa_machine.interned_states;
+  // Frames popped by the 'POP' stack operations.
+  vector<uint32_t> popped_frames(stream.size());
+  {
+    vector<uint32_t> frames;
+    for (Offset i = 0; i < stream.size(); i++) {
+      auto t = machine->FindTransition(state_trace[i], stream[i]);
+      if (t->type == StackOperation::PUSH) {
+        frames.push_back(t->frame);
+      } else if (t->type == StackOperation::POP) {
+        popped_frames[i] = frames.back();
+        frames.pop_back();
+      }
+    }
+  }
+  auto& final_states = machine->states[current_state];
+  uint32_t cur = 0;
+  while (not nfa_machine.is_final_interned_state[final_states[cur]]) {
+    cur++;
+  }
+  vector<AParseMachine::ParsingStream> parsing_stream(1+stream.size());
+  parsing_stream[stream.size()] = nfa_machine.final_states.at(
+                                      nfa_states[final_states[cur]]);
+  // PopBackLinks of the 'POP' stack operations whose 'PUSH' is not reached
+  // yet.
+  vector<const DeterministicAParseMachine::PopBackLink*> construction_stack;
+  for (Offset i = static_cast<Offset>(stream.size()) - 1; i >= 0; i--) {
+    auto& states = machine->states[state_trace[i]];
+    Alphabet a = stream[i];
+    auto t = machine->FindTransition(state_trace[i], a);
+    switch (t->type) {
+      case StackOperation::PUSH: {
+        auto link = construction_stack.back();
+        auto edges = nfa_machine.FindEdges(states[link->frame_source], a);
+        parsing_stream[i] = edges->special_parsing_streams[link->special_edges]
+                                                          [link->edge];
+        cur = link->frame_source;
+        construction_stack.pop_back();
+        break;
+      }
+      case StackOperation::POP: {
+        auto& entry = machine->FindPopEntry(*t, popped_frames[i]);
+        auto& link = machine->pop_back_links[entry.back_links + cur];
+        construction_stack.push_back(&link);
+        cur = link.source;
+        auto& frame = machine->frames[popped_frames[i]];
+        auto edges = nfa_machine.FindEdges(
+                         machine->states[frame.first][link.frame_source],
+                         frame.second);
+        int ent = edges->special_next_states[link.special_edges].first;
+        parsing_stream[i] = nfa_machine.enclosed_subnfa_map.at(ent)
+                                .final_states.at(nfa_states[states[cur]]);
+        break;
+      }
+      case StackOperation::NOP: {
+        auto& link = machine->back_links[t->back_links + cur];
+        auto edges = nfa_machine.FindEdges(states[link.source], a);
+        parsing_stream[i] = edges->parsing_streams[link.edge];
+        cur = link.source;
+        break;
+      }
+      default: assert(false);
+    }
+  }
+  helpers::ConstructTree(parsing_stream, output);
+  return true;
+}
+
+}  // namespace v2
+}  // namespace aparse
@@ -0,0 +1,70 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#ifndef APARSE_SRC_V2_DETERMINISTIC_CORE_PARSER_HPP_
+#define APARSE_SRC_V2_DETERMINISTIC_CORE_PARSER_HPP_
+
+#include <unordered_set>
+#include <vector>
+
+#include <quick/debug_stream_decl.hpp>
+
+#include "aparse/error.hpp"
+#include "src/abstract_core_parser.hpp"
+#include "src/v2/deterministic_aparse_machine.hpp"
+
+namespace aparse {
+namespace v2 {
+
+/** CoreParser of Parser::VERY_LOW_COMPRESSION machine type, parsing with
+ *  DeterministicAParseMachine. Feed is a lookup in the transition table of
+ *  the current DFA state and an optional push/pop of a stack frame. Only the
+ *  DFA states are recorded while feeding, the NFA path needed for the parse
+ *  tree is recovered from them in Parse.
+ *  DeterministicAParseMachine must live longer than this object. */
+class DeterministicCoreParser : public AbstractCoreParser {
+ public:
+  DeterministicCoreParser() = default;
+  explicit DeterministicCoreParser(const qk::AbstractType* machine);
+  void SetAParseMachine(const qk::AbstractType* machine);
+
+  bool Parse(CoreParseNode* output);
+  void ParseOrDie(CoreParseNode* output);
+  bool Parse(CoreParseNode* output, Error* error);
+
+  bool Feed(Alphabet alphabet);
+  void FeedOrDie(Alphabet alphabet);
+  bool Feed(Alphabet alphabet, Error* error);
+  bool Feed(const vector<Alphabet>& stream);
+  void FeedOrDie(const vector<Alphabet>& stream);
+  bool Feed(const vector<Alphabet>& stream, Error* error);
+
+  bool CanFeed(Alphabet alphabet) const;
+  bool IsFinal() const;
+  void Reset();
+  const vector<Alphabet>& GetStream() const;
+  unordered_set<Alphabet> PossibleAlphabets() const;
+  unordered_set<Alphabet> PossibleAlphabets(int k) const;  // return k only.
+  void DebugStream(qk::DebugStream&) const;  // NOLINT
+
+ private:
+  using StateId = AParseMachine::StateId;
+  using StackOperation = AParseMachine::StackOperation;
+  const DeterministicAParseMachine* machine = nullptr;
+  // Invariant: Update the default values of these members in Reset method.
+  bool is_valid_path_so_far = true;
+  uint32_t current_state = 0;
+  // Frames of DeterministicAParseMachine.
+  vector<uint32_t> stack;
+  vector<Alphabet> stream;
+  // DFA state before feeding stream[i] is state_trace[i].
+  vector<uint32_t> state_trace;
+
+  /** Same as CanFeed, ignoring the invalid alphabets fed before. */
+  bool HasTransition(Alphabet alphabet) const;
+};
+
+}  // namespace v2
+}  // namespace aparse
+
+#endif  // APARSE_SRC_V2_DETERMINISTIC_CORE_PARSER_HPP_
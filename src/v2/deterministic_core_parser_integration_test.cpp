@@ -0,0 +1,139 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "aparse/error.hpp"
+#include "src/v2/aparse_machine_builder.hpp"
+#include "src/v2/core_parser.hpp"
+#include "src/v2/deterministic_aparse_machine.hpp"
+#include "src/v2/deterministic_core_parser.hpp"
+
+#include "tests/samples/sample_aparse_grammars.hpp"
+
+using aparse::AParseGrammar;
+using aparse::Alphabet;
+using aparse::CoreParseNode;
+using aparse::v2::AParseMachine;
+using aparse::v2::AParseMachineBuilder;
+using aparse::v2::CoreParser;
+using aparse::v2::DeterministicAParseMachine;
+using aparse::v2::DeterministicCoreParser;
+using std::vector;
+
+class DeterministicCoreParserIntegrationTest : public ::testing::Test {
+ public:
+  vector<AParseMachine> machines;
+  vector<DeterministicAParseMachine> deterministic_machines;
+  DeterministicCoreParserIntegrationTest() {
+    // Please Refer to `samples/sample_aparse_grammars.hpp` for the details of
+    // these grammars.
+    for (auto& grammar : {test::SampleGrammar1(),
+                          test::SampleGrammar2(),
+                          test::SampleGrammar3(),
+                          test::SampleGrammar4()}) {
+      machines.emplace_back();
+      AParseMachineBuilder(grammar).Build(&machines.back());
+      deterministic_machines.emplace_back();
+      deterministic_machines.back().Build(machines.back());
+    }
+  }
+
+ protected:
+  void SetUp() override {}
+};
+
+TEST_F(DeterministicCoreParserIntegrationTest, Basic) {
+  // SampleGrammar1: ()()((())())
+  DeterministicCoreParser parser(&deterministic_machines[0]);
+  EXPECT_TRUE(parser.Feed({0, 1, 0, 1, 0, 0, 0, 1, 1, 0, 1, 1}));
+  CoreParseNode tree;
+  EXPECT_TRUE(parser.Parse(&tree));
+  CoreParseNode expected(0,
+                         {0, 12},
+                         {CoreParseNode(
+                            0,
+                            {0, 12},
+                            {CoreParseNode(0, {1, 1}),
+                             CoreParseNode(0, {3, 3}),
+                             CoreParseNode(
+                               0,
+                               {5, 11},
+                               {CoreParseNode(0,
+                                              {6, 8},
+                                              {CoreParseNode(0, {7, 7})}),
+                                CoreParseNode(0, {10, 10})})})});
+  EXPECT_EQ(expected, tree);
+  // (()
+  parser.Reset();
+  EXPECT_TRUE(parser.Feed({0, 0, 1}));
+  EXPECT_FALSE(parser.IsFinal());
+  EXPECT_FALSE(parser.Parse(&tree));
+  // ()())
+  parser.Reset();
+  aparse::Error error;
+  EXPECT_FALSE(parser.Feed({0, 1, 0, 1, 1}, &error));
+  EXPECT_EQ(error.status, aparse::Error::PARSING_ERROR_INVALID_TOKENS);
+  EXPECT_EQ(error.error_position.first, 4);
+  EXPECT_EQ(error.possible_alphabets, (std::unordered_set<int>{0}));
+}
+
+// Random walks over the possible alphabets, both the parsers must agree at
+// every step.
+TEST_F(DeterministicCoreParserIntegrationTest, SameAsCoreParser) {
+  std::mt19937 random_engine(7);
+  for (int m = 0; m < machines.size(); m++) {
+    CoreParser parser(&machines[m]);
+    DeterministicCoreParser deterministic_parser(&deterministic_machines[m]);
+    for (int iteration = 0; iteration < 200; iteration++) {
+      parser.Reset();
+      deterministic_parser.Reset();
+      int length = random_engine() % 40;
+      for (int i = 0; i < length; i++) {
+        auto possible_alphabets = parser.PossibleAlphabets();
+        ASSERT_EQ(possible_alphabets, deterministic_parser.PossibleAlphabets());
+        if (possible_alphabets.empty()) break;
+        vector<Alphabet> alphabets(possible_alphabets.begin(),
+                                   possible_alphabets.end());
+        Alphabet a = alphabets[random_engine() % alphabets.size()];
+        ASSERT_EQ(parser.Feed(a), deterministic_parser.Feed(a));
+      }
+      ASSERT_EQ(parser.IsFinal(), deterministic_parser.IsFinal());
+      if (parser.IsFinal()) {
+        CoreParseNode tree, deterministic_tree;
+        EXPECT_TRUE(parser.Parse(&tree));
+        EXPECT_TRUE(deterministic_parser.Parse(&deterministic_tree));
+        EXPECT_EQ(tree, deterministic_tree);
+      }
+    }
+  }
+}
+
+TEST_F(DeterministicCoreParserIntegrationTest, ImportExport) {
+  for (auto& machine : deterministic_machines) {
+    DeterministicAParseMachine imported_machine;
+    EXPECT_TRUE(imported_machine.Import(machine.Export()));
+    EXPECT_EQ(machine, imported_machine);
+  }
+  DeterministicAParseMachine m3;
+  m3.Import(deterministic_machines[2].Export());
+  DeterministicCoreParser parser(&m3);
+  // SampleGrammar3: [NUM, NUM]
+  EXPECT_TRUE(parser.Feed({0, 6, 4, 6, 1}));
+  CoreParseNode tree;
+  EXPECT_TRUE(parser.Parse(&tree));
+  CoreParseNode expected(0,
+                         {0, 5},
+                         {CoreParseNode(
+                            0,
+                            {0, 5},
+                            {CoreParseNode(
+                              1,
+                              {1, 4},
+                              {CoreParseNode(0, {1, 2}),
+                               CoreParseNode(0, {3, 4})})})});
+  EXPECT_EQ(expected, tree);
+}
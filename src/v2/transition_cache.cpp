@@ -0,0 +1,254 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#include "src/v2/transition_cache.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "quick/debug_stream.hpp"
+
+namespace aparse {
+namespace v2 {
+
+constexpr size_t TransitionCache::kDefaultMaxTransitions;
+
+void TransitionCache::BackLink::DebugStream(qk::DebugStream& ds) const {
+  ds << "source = " << source << ", source_index = " << source_index
+     << ", edge = " << edge << ", special_edges = " << special_edges
+     << ", enclosed_non_terminal = " << enclosed_non_terminal
+     << ", enclosed_source = " << enclosed_source
+     << ", enclosed_source_index = " << enclosed_source_index;
+}
+
+const TransitionCache::Transition TransitionCache::kNoTransition;
+
+TransitionCache::TransitionCache(const AParseMachine* machine,
+                                 size_t max_transitions)
+  : machine(machine), max_transitions(std::max<size_t>(max_transitions, 2)) {
+  APARSE_ASSERT(machine != nullptr && machine->initialized);
+  num_alphabets = machine->num_interned_alphabets;
+  std::lock_guard<std::mutex> lock(mutex);
+  FlushLocked();
+}
+
+size_t TransitionCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return generation->transitions.size() + generation->pop_transitions.size();
+}
+
+std::shared_ptr<const TransitionCache::Generation>
+TransitionCache::CurrentGeneration() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return generation;
+}
+
+void TransitionCache::FlushLocked() {
+  auto new_generation = std::make_shared<Generation>();
+  new_generation->id = generation_id.load(std::memory_order_relaxed) + 1;
+  generation = std::move(new_generation);
+  std::vector<StateId> states = {machine->interned_start_state};
+  generation->start_states = InternLocked(&states);
+  generation_id.store(generation->id, std::memory_order_release);
+}
+
+void TransitionCache::Migrate(std::vector<const StateSet*>* state_sets,
+                              std::shared_ptr<const Generation>* output) {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<StateId> states;
+  for (auto& state_set : *state_sets) {
+    states = state_set->states;
+    state_set = InternLocked(&states);
+  }
+  *output = generation;
+}
+
+const TransitionCache::StateSet* TransitionCache::InternLocked(
+    std::vector<StateId>* states) {
+  std::sort(states->begin(), states->end());
+  auto& state_set = generation->state_sets[*states];
+  if (state_set != nullptr) {
+    return state_set.get();
+  }
+  state_set.reset(new StateSet());
+  state_set->states = *states;
+  for (StateId s : *states) {
+    state_set->is_final = state_set->is_final ||
+                          machine->is_final_interned_state[s];
+  }
+  state_set->generation = generation->id;
+  state_set->next.reset(new std::atomic<const Transition*>[num_alphabets]);
+  for (uint32_t a = 0; a < num_alphabets; a++) {
+    state_set->next[a].store(nullptr, std::memory_order_relaxed);
+  }
+  return state_set.get();
+}
+
+// @returns false if there are no next states.
+bool TransitionCache::ComputeTransition(const StateSet& states,
+                                        Alphabet a,
+                                        const StateSet* frame_states,
+                                        Alphabet frame_alphabet,
+                                        Transition* transition,
+                                        std::vector<StateId>* next) const {
+  std::vector<std::pair<int, StateId>> sources;
+  transition->type = machine->GetInternedStackOps(states.states, a, &sources);
+  next->clear();
+  // Index of @s in the sorted @states.
+  auto lIndex = [](const std::vector<StateId>& states, StateId s) {
+    return static_cast<uint32_t>(
+        std::lower_bound(states.begin(), states.end(), s) - states.begin());
+  };
+  auto lSortNext = [&]() {
+    std::sort(next->begin(), next->end());
+    next->erase(std::unique(next->begin(), next->end()), next->end());
+  };
+  auto& back_links = transition->back_links;
+  switch (transition->type) {
+    case StackOperation::PUSH: {
+      for (auto& x : sources) {
+        next->push_back(machine->interned_enclosed_start_states.at(x.first));
+      }
+      lSortNext();
+      return true;
+    }
+    case StackOperation::POP: {
+      if (frame_states == nullptr) {
+        return false;
+      }
+      // frame_sources[k][i] is the item of `sources` for the i-th
+      // enclosed-non-terminal in the `special_next_states` of the k-th frame
+      // state, or nullptr.
+      std::vector<std::vector<const std::pair<int, StateId>*>> frame_sources;
+      for (StateId s : frame_states->states) {
+        frame_sources.emplace_back();
+        auto edges = machine->FindEdges(s, frame_alphabet);
+        if (edges == nullptr) continue;
+        for (auto& item : edges->special_next_states) {
+          auto it = std::find_if(sources.begin(), sources.end(),
+                                 [&](const std::pair<int, StateId>& x) {
+                                   return x.first == item.first;
+                                 });
+          frame_sources.back().push_back(
+              (it == sources.end()) ? nullptr : &*it);
+          if (it != sources.end()) {
+            next->insert(next->end(), item.second.begin(), item.second.end());
+          }
+        }
+      }
+      lSortNext();
+      back_links.resize(next->size());
+      // The last back-pointer of a target state is taken.
+      for (uint32_t k = 0; k < frame_states->states.size(); k++) {
+        StateId s = frame_states->states[k];
+        auto edges = machine->FindEdges(s, frame_alphabet);
+        if (edges == nullptr) continue;
+        for (uint32_t i = 0; i < edges->special_next_states.size(); i++) {
+          auto x = frame_sources[k][i];
+          if (x == nullptr) continue;
+          auto& targets = edges->special_next_states[i].second;
+          for (uint32_t e = 0; e < targets.size(); e++) {
+            back_links[lIndex(*next, targets[e])] = BackLink{
+                s, k, e, i, x->first, x->second,
+                lIndex(states.states, x->second)};
+          }
+        }
+      }
+      return true;
+    }
+    default: {
+      for (StateId s : states.states) {
+        auto edges = machine->FindEdges(s, a);
+        if (edges != nullptr) {
+          next->insert(next->end(), edges->next_states.begin(),
+                       edges->next_states.end());
+        }
+      }
+      lSortNext();
+      back_links.resize(next->size());
+      std::vector<uint8_t> linked(next->size(), false);
+      // The first back-pointer of a target state is taken.
+      for (uint32_t k = 0; k < states.states.size(); k++) {
+        StateId s = states.states[k];
+        auto edges = machine->FindEdges(s, a);
+        if (edges == nullptr) continue;
+        for (uint32_t e = 0; e < edges->next_states.size(); e++) {
+          uint32_t j = lIndex(*next, edges->next_states[e]);
+          if (not linked[j]) {
+            linked[j] = true;
+            back_links[j] = BackLink{s, k, e, 0, -1, 0, 0};
+          }
+        }
+      }
+      return not next->empty();
+    }
+  }
+}
+
+const TransitionCache::Transition* TransitionCache::NextLocked(
+    const StateSet& states,
+    Alphabet a,
+    const StateSet* frame_states,
+    Alphabet frame_alphabet) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (states.generation != generation->id ||
+      (frame_states != nullptr &&
+       frame_states->generation != generation->id)) {
+    return nullptr;
+  }
+  // Another thread might have computed it meanwhile.
+  const Transition* transition = states.next[a].load(
+                                     std::memory_order_relaxed);
+  const PopTransition* pop_transitions = nullptr;
+  if (transition != nullptr) {
+    if (transition->type != StackOperation::POP || frame_states == nullptr) {
+      return transition;
+    }
+    pop_transitions = transition->pop_transitions.load(
+                          std::memory_order_relaxed);
+    for (auto it = pop_transitions; it != nullptr; it = it->next) {
+      if (it->frame_states == frame_states &&
+          it->frame_alphabet == frame_alphabet) {
+        return &it->transition;
+      }
+    }
+  }
+  if (generation->transitions.size() + generation->pop_transitions.size()
+        >= max_transitions) {
+    FlushLocked();
+    return nullptr;
+  }
+  std::vector<StateId> next_states;
+  if (transition == nullptr) {
+    // The transitions independent of the stack, and the stack operation.
+    std::unique_ptr<Transition> new_transition(new Transition());
+    if (ComputeTransition(states, a, nullptr, 0, new_transition.get(),
+                          &next_states)) {
+      new_transition->next_states = InternLocked(&next_states);
+    }
+    transition = new_transition.get();
+    generation->transitions.push_back(std::move(new_transition));
+    states.next[a].store(transition, std::memory_order_release);
+    if (transition->type != StackOperation::POP || frame_states == nullptr) {
+      return transition;
+    }
+  }
+  std::unique_ptr<PopTransition> pop_transition(new PopTransition());
+  pop_transition->frame_states = frame_states;
+  pop_transition->frame_alphabet = frame_alphabet;
+  pop_transition->next = pop_transitions;
+  if (ComputeTransition(states, a, frame_states, frame_alphabet,
+                        &pop_transition->transition, &next_states)) {
+    pop_transition->transition.next_states = InternLocked(&next_states);
+  }
+  transition->pop_transitions.store(pop_transition.get(),
+                                    std::memory_order_release);
+  generation->pop_transitions.push_back(std::move(pop_transition));
+  return &generation->pop_transitions.back()->transition;
+}
+
+}  // namespace v2
+}  // namespace aparse
@@ -0,0 +1,191 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+#ifndef APARSE_SRC_V2_TRANSITION_CACHE_HPP_
+#define APARSE_SRC_V2_TRANSITION_CACHE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "quick/debug_stream_decl.hpp"
+#include "quick/unordered_map.hpp"
+#include "quick/utility.hpp"
+
+#include "aparse/common_headers.hpp"
+#include "src/v2/aparse_machine.hpp"
+
+namespace aparse {
+namespace v2 {
+
+/** Lazily determinized transitions of AParseMachine, used by CoreParser.
+ *  The sets of the interned NFA states reached by CoreParser are interned as
+ *  StateSets, and the transition taken on an alphabet from a StateSet is
+ *  computed once and memoized along with its back-pointers.
+ *  A single TransitionCache is shared by all the ParserInstances of a Parser,
+ *  it can be used from multiple threads concurrently. Like the lazy DFA of
+ *  RE2, a StateSet has an array of its transitions indexed by the alphabet,
+ *  which is read without any lock. The lock is taken only on a miss.
+ *  The cache is bounded: Once it holds `max_transitions` transitions, it's
+ *  flushed by starting a new Generation. The StateSets and the Transitions
+ *  handed out are raw pointers, valid as long as their Generation is held
+ *  by the caller. */
+class TransitionCache : public quick::AbstractType {
+ public:
+  using StateId = AParseMachine::StateId;
+  using StackOperation = AParseMachine::StackOperation;
+
+  /** Back-pointer of a state reached by a transition. The back-links of a
+   *  transition are parallel to the states of its `next_states`, and a state
+   *  is referred by its index in the StateSet it belongs to, so that the
+   *  parse tree is constructed without any search. */
+  struct BackLink {
+    void DebugStream(qk::DebugStream& ds) const;  // NOLINT
+    // Its previous state, and its index. In case of 'POP' stack operation,
+    // it's previous state among the states pushed in stack.
+    StateId source;
+    uint32_t source_index;
+    // Index of the state reached in the edges of `source`: In the
+    // `next_states` for 'NOP', and in the `special_next_states` for 'POP'.
+    uint32_t edge;
+    // Only for 'POP' stack operation: Index of the recognized
+    // enclosed_non_terminal in the `special_next_states` of `source`, the
+    // enclosed_non_terminal and it's previous state in enclose_nfa.
+    uint32_t special_edges;
+    int enclosed_non_terminal;
+    StateId enclosed_source;
+    uint32_t enclosed_source_index;
+  };
+
+  struct Transition;
+  struct PopTransition;
+
+  /** Set of interned states. */
+  struct StateSet {
+    std::vector<StateId> states;
+    bool is_final = false;
+    // Id of the Generation owning it.
+    uint64_t generation = 0;
+    // next[a] is the transition on the alphabet `a` independent of the
+    // stack, or nullptr if it's not computed yet.
+    std::unique_ptr<std::atomic<const Transition*>[]> next;
+  };
+
+  struct Transition {
+    StackOperation::OperationType type = StackOperation::NOP;
+    // nullptr if the alphabet cannot be fed.
+    const StateSet* next_states = nullptr;
+    std::vector<BackLink> back_links;
+    // Only for 'POP' stack operation: Linked list of the transitions
+    // computed so far for the frames on top of the stack. Prepended under
+    // the lock of the cache.
+    mutable std::atomic<const PopTransition*> pop_transitions{nullptr};
+  };
+
+  /** 'POP' transition, when the frame (frame_states, frame_alphabet) is on
+   *  top of the stack. */
+  struct PopTransition {
+    const StateSet* frame_states;
+    Alphabet frame_alphabet;
+    Transition transition;
+    const PopTransition* next;
+  };
+
+  /** The StateSets and the Transitions created between two flushes of the
+   *  cache. It's freed once it's flushed and released by all the parsers. */
+  struct Generation {
+    uint64_t id;
+    const StateSet* start_states;
+    qk::unordered_map<std::vector<StateId>,
+                      std::unique_ptr<StateSet>> state_sets;
+    std::vector<std::unique_ptr<Transition>> transitions;
+    std::vector<std::unique_ptr<PopTransition>> pop_transitions;
+  };
+
+  explicit TransitionCache(const AParseMachine* machine,
+                           size_t max_transitions = kDefaultMaxTransitions);
+
+  /** The current generation. */
+  std::shared_ptr<const Generation> CurrentGeneration() const;
+
+  /** Id of the current generation, incremented by every flush. */
+  uint64_t GenerationId() const {
+    return generation_id.load(std::memory_order_acquire);
+  }
+
+  /** Transition on @a from @states. In case of 'POP' stack operation,
+   *  @frame_states and @frame_alphabet are the states and the alphabet on
+   *  top of the stack. @frame_states is nullptr if the stack is empty.
+   *  Lock free if the transition is computed already.
+   *  @returns nullptr if the transition is not computed yet, and @states or
+   *  @frame_states belong to a flushed generation. They must be migrated to
+   *  the current generation then, before retrying. */
+  inline const Transition* Next(const StateSet& states,
+                                Alphabet a,
+                                const StateSet* frame_states,
+                                Alphabet frame_alphabet) {
+    if (static_cast<uint32_t>(a) >= num_alphabets) {
+      return &kNoTransition;
+    }
+    const Transition* transition = states.next[a].load(
+                                       std::memory_order_acquire);
+    if (transition == nullptr) {
+      return NextLocked(states, a, frame_states, frame_alphabet);
+    }
+    if (transition->type != StackOperation::POP || frame_states == nullptr) {
+      return transition;
+    }
+    for (auto pop_transition = transition->pop_transitions.load(
+                                   std::memory_order_acquire);
+         pop_transition != nullptr;
+         pop_transition = pop_transition->next) {
+      if (pop_transition->frame_states == frame_states &&
+          pop_transition->frame_alphabet == frame_alphabet) {
+        return &pop_transition->transition;
+      }
+    }
+    return NextLocked(states, a, frame_states, frame_alphabet);
+  }
+
+  /** Replace the StateSets of @state_sets with the same sets of the current
+   *  generation, which is stored in @generation. */
+  void Migrate(std::vector<const StateSet*>* state_sets,
+               std::shared_ptr<const Generation>* generation);
+
+  /** Number of the transitions in the cache. */
+  size_t size() const;
+
+  static constexpr size_t kDefaultMaxTransitions = 1 << 16;
+
+ private:
+  const Transition* NextLocked(const StateSet& states,
+                               Alphabet a,
+                               const StateSet* frame_states,
+                               Alphabet frame_alphabet);
+  const StateSet* InternLocked(std::vector<StateId>* states);
+  void FlushLocked();
+  bool ComputeTransition(const StateSet& states,
+                         Alphabet a,
+                         const StateSet* frame_states,
+                         Alphabet frame_alphabet,
+                         Transition* transition,
+                         std::vector<StateId>* next) const;
+
+  // The transition on the alphabets having no edges.
+  static const Transition kNoTransition;
+
+  const AParseMachine* machine;
+  size_t max_transitions;
+  uint32_t num_alphabets;
+  std::atomic<uint64_t> generation_id{0};
+  mutable std::mutex mutex;
+  // Guarded by `mutex`.
+  std::shared_ptr<Generation> generation;
+};
+
+}  // namespace v2
+}  // namespace aparse
+
+#endif  // APARSE_SRC_V2_TRANSITION_CACHE_HPP_
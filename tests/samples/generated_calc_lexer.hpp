@@ -0,0 +1,103 @@
+// Generated by aparse::LexerCodeGenerator. Do not edit.
+
+#ifndef APARSE_GENERATED_LEXER_CALC_LEXER_HPP_
+#define APARSE_GENERATED_LEXER_CALC_LEXER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace calc_lexer {
+
+// The tables are static members of a class template, so that they have a
+// single definition across the translation units including this header.
+template<typename Unused = void>
+struct LexerTables {
+  static constexpr int32_t kNumAlphabetClasses = 8;
+  static constexpr int32_t kStartState = 0;
+  static constexpr uint8_t kAlphabetClass[] = {
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 2, 3, 4, 5, 0, 0, 0, 0, 6, 6,
+      6, 6, 6, 6, 6, 6, 6, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 7, 0, 7, 7, 7,
+      7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0,
+  };
+  // kTransitionTable[s * kNumAlphabetClasses + c] = target of the state s on
+  // the bytes of class c, or -1.
+  static constexpr int16_t kTransitionTable[] = {
+      -1, 1, 7, 6, 5, 4, 3, 2, -1, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, 2, 2, -1, -1, -1, -1, -1, -1, 3, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1,
+  };
+  static constexpr uint8_t kIsFinal[] = {
+      0, 1, 1, 1, 1, 1, 1, 1,
+  };
+  static constexpr uint8_t kIsSkip[] = {
+      0, 1, 0, 0, 0, 0, 0, 0,
+  };
+  static constexpr int32_t kTokenId[] = {
+      0, 0, 2, 1, 3, 4, 6, 5,
+  };
+};
+
+template<typename Unused>
+constexpr int32_t LexerTables<Unused>::kNumAlphabetClasses;
+template<typename Unused>
+constexpr int32_t LexerTables<Unused>::kStartState;
+template<typename Unused>
+constexpr uint8_t LexerTables<Unused>::kAlphabetClass[];
+template<typename Unused>
+constexpr int16_t LexerTables<Unused>::kTransitionTable[];
+template<typename Unused>
+constexpr uint8_t LexerTables<Unused>::kIsFinal[];
+template<typename Unused>
+constexpr uint8_t LexerTables<Unused>::kIsSkip[];
+template<typename Unused>
+constexpr int32_t LexerTables<Unused>::kTokenId[];
+
+/** Lex [data, data+len). sink(token_id, start, end) is called for
+ *  every token, except for the tokens of the skip rules.
+ *  @returns false in case of invalid or incomplete tokens. */
+template<typename Sink>
+inline bool Lex(const char* data, size_t len, Sink& sink) {
+  using T = LexerTables<>;
+  size_t token_start = 0;
+  int32_t state = T::kStartState;
+  for (size_t i = 0; i < len; i++) {
+    int32_t c = T::kAlphabetClass[static_cast<uint8_t>(data[i])];
+    int32_t next_state = T::kTransitionTable[state * T::kNumAlphabetClasses
+                                             + c];
+    if (next_state < 0) {
+      if (not T::kIsFinal[state]) {
+        return false;
+      }
+      if (not T::kIsSkip[state]) {
+        sink(T::kTokenId[state], token_start, i);
+      }
+      token_start = i;
+      state = T::kStartState;
+      next_state = T::kTransitionTable[state * T::kNumAlphabetClasses + c];
+      if (next_state < 0) {
+        return false;
+      }
+    }
+    state = next_state;
+  }
+  if (not T::kIsFinal[state]) {
+    return false;
+  }
+  if (not T::kIsSkip[state]) {
+    sink(T::kTokenId[state], token_start, len);
+  }
+  return true;
+}
+
+}  // namespace calc_lexer
+
+#endif  // APARSE_GENERATED_LEXER_CALC_LEXER_HPP_
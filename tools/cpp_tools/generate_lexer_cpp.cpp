@@ -0,0 +1,89 @@
+// Copyright: 2015 Mohit Saini
+// Author: Mohit Saini (mohitsaini1196@gmail.com)
+
+// Generates the standalone C++ source of a lexer.
+// Usage: generate_lexer_cpp <rules-file> <namespace> [<output-file>]
+//
+// Each non-empty line of the rules-file is a lexer rule of the main section:
+//   <token-id><TAB><regex>
+//   skip<TAB><regex>
+// Lines starting with '#' are ignored. "\n" and "\t" in a regex stand for
+// the new-line and the tab characters.
+// Refer to `include/aparse/lexer_code_generator.hpp` for the generated code.
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "aparse/lexer_builder.hpp"
+#include "aparse/lexer_code_generator.hpp"
+
+namespace {
+
+std::string UnescapeRegex(const std::string& input) {
+  std::string output;
+  for (size_t i = 0; i < input.size(); i++) {
+    if (input[i] == '\\' && i + 1 < input.size()) {
+      char c = input[++i];
+      if (c == 'n') {
+        output += '\n';
+      } else if (c == 't') {
+        output += '\t';
+      } else {
+        output += '\\';
+        output += c;
+      }
+    } else {
+      output += input[i];
+    }
+  }
+  return output;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0]
+              << " <rules-file> <namespace> [<output-file>]" << std::endl;
+    return 1;
+  }
+  std::ifstream rules_file(argv[1]);
+  if (not rules_file) {
+    std::cerr << "Cannot open " << argv[1] << std::endl;
+    return 1;
+  }
+  aparse::LexerGrammar lexer_grammar;
+  auto& rules = lexer_grammar.rules[lexer_grammar.main_section];
+  std::string line;
+  for (int line_number = 1; std::getline(rules_file, line); line_number++) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    auto tab = line.find('\t');
+    if (tab == std::string::npos) {
+      std::cerr << argv[1] << ":" << line_number << ": expected a TAB"
+                << std::endl;
+      return 1;
+    }
+    std::string token = line.substr(0, tab);
+    rules.emplace_back(UnescapeRegex(line.substr(tab + 1)));
+    if (token == "skip") {
+      rules.back().Skip();
+    } else {
+      rules.back().Token(std::stoi(token));
+    }
+  }
+  try {
+    auto code = aparse::LexerCodeGenerator::Generate(lexer_grammar, argv[2]);
+    if (argc > 3) {
+      std::ofstream(argv[3]) << code;
+    } else {
+      std::cout << code;
+    }
+  } catch (const aparse::Error& error) {
+    std::cerr << error.error_message << std::endl;
+    return 1;
+  }
+  return 0;
+}
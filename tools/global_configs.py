@@ -53,6 +53,9 @@ configs.dependency_configs = [
                 hdrs = ["tests/samples/sample_internal_parser_rules.hpp"],
                 deps = ["src/simple_aparse_grammar_builder"]),
 
+  br.CppLibrary("tests/samples/generated_calc_lexer",
+                hdrs = ["tests/samples/generated_calc_lexer.hpp"]),
+
   br.CppLibrary("src/parse_char_regex_rules",
                 hdrs = ["src/parse_char_regex_rules.hpp"],
                 srcs = ["src/parse_char_regex_rules.cpp"],
@@ -67,6 +70,9 @@ configs.dependency_configs = [
                 hdrs = ["include/aparse/utils/any.hpp"],
                 deps = ["toolchain/quick"]),
 
+  br.CppLibrary("aparse/utils/string_view",
+                hdrs = ["include/aparse/utils/string_view.hpp"]),
+
   br.CppLibrary("src/parse_char_regex",
                 hdrs = ["src/parse_char_regex.hpp"],
                 srcs = ["src/parse_char_regex.cpp"],
@@ -158,16 +164,38 @@ configs.dependency_configs = [
                         "aparse/error",
                         "aparse/core_parse_node"]),
 
+  br.CppLibrary("src/v2/transition_cache",
+                hdrs = ["src/v2/transition_cache.hpp"],
+                srcs = ["src/v2/transition_cache.cpp"],
+                deps = ["src/v2/aparse_machine",
+                        "toolchain/quick"]),
+
   br.CppLibrary("src/v2/core_parser",
                 hdrs = ["src/v2/core_parser.hpp"],
                 srcs = ["src/v2/core_parser.cpp"],
                 deps = ["src/v2/aparse_machine",
+                        "src/v2/transition_cache",
+                        "aparse/error",
+                        "src/abstract_core_parser"]),
+
+  br.CppLibrary("src/v2/deterministic_aparse_machine",
+                hdrs = ["src/v2/deterministic_aparse_machine.hpp"],
+                srcs = ["src/v2/deterministic_aparse_machine.cpp"],
+                deps = ["src/v2/aparse_machine",
+                        "toolchain/quick"]),
+
+  br.CppLibrary("src/v2/deterministic_core_parser",
+                hdrs = ["src/v2/deterministic_core_parser.hpp"],
+                srcs = ["src/v2/deterministic_core_parser.cpp"],
+                deps = ["src/v2/deterministic_aparse_machine",
+                        "src/v2/core_parser",
                         "aparse/error",
                         "src/abstract_core_parser"]),
 
   br.CppLibrary("aparse/lexer_machine",
                 hdrs = ["include/aparse/lexer_machine.hpp"],
-                deps = []),
+                srcs = ["src/lexer_machine.cpp"],
+                deps = ["toolchain/quick"]),
 
   br.CppLibrary("src/lexer_machine_builder",
                 hdrs = ["src/lexer_machine_builder.hpp"],
@@ -175,25 +203,80 @@ configs.dependency_configs = [
                 deps = ["aparse/lexer_machine",
                         "aparse/regex"]),
 
+  br.CppTest("src/lexer_machine_builder_test",
+                srcs = ["src/lexer_machine_builder_test.cpp"],
+                deps = ["src/lexer_machine_builder",
+                        "src/regex_helpers"]),
+
   br.CppLibrary("aparse/parser_builder",
                 hdrs = ["include/aparse/parser_builder.hpp"],
                 srcs = ["src/parser_builder.cpp"],
                 deps = ["aparse/parser",
                         "src/internal_parser_builder",
                         "src/parse_regex_rule",
+                        "src/helpers",
                         "aparse/error"]),
 
+  br.CppLibrary("aparse/keyword_table",
+                hdrs = ["include/aparse/keyword_table.hpp"],
+                srcs = ["src/keyword_table.cpp"],
+                deps = ["toolchain/quick"]),
+
+  br.CppTest("src/keyword_table_test",
+                srcs = ["src/keyword_table_test.cpp"],
+                deps = ["aparse/keyword_table"]),
+
+  br.CppLibrary("aparse/lexer_input",
+                hdrs = ["include/aparse/lexer_input.hpp"],
+                srcs = ["src/lexer_input.cpp"],
+                deps = ["aparse/utils/string_view"]),
+
+  br.CppTest("src/lexer_input_integration_test",
+                srcs = ["src/lexer_input_integration_test.cpp"],
+                deps = ["aparse/lexer_builder",
+                        "aparse/lexer_input"]),
+
   br.CppLibrary("aparse/lexer",
                 hdrs = ["include/aparse/lexer.hpp"],
                 srcs = ["src/lexer.cpp"],
-                deps = ["aparse/error"]),
+                deps = ["aparse/error",
+                        "aparse/keyword_table",
+                        "aparse/lexer_input",
+                        "aparse/utils/string_view"]),
+
+  br.CppLibrary("aparse/lexer_code_generator",
+                hdrs = ["include/aparse/lexer_code_generator.hpp"],
+                srcs = ["src/lexer_code_generator.cpp"],
+                deps = ["aparse/lexer_builder"]),
+
+  br.CppLibrary("aparse/batch_lexer",
+                hdrs = ["include/aparse/batch_lexer.hpp"],
+                srcs = ["src/batch_lexer.cpp"],
+                deps = ["aparse/lexer",
+                        "aparse/error",
+                        "aparse/utils/string_view"]),
+
+  br.CppLibrary("aparse/incremental_lexer",
+                hdrs = ["include/aparse/incremental_lexer.hpp"],
+                srcs = ["src/incremental_lexer.cpp"],
+                deps = ["aparse/lexer",
+                        "aparse/error",
+                        "aparse/utils/string_view"]),
+
+  br.CppLibrary("aparse/parallel_lexer",
+                hdrs = ["include/aparse/parallel_lexer.hpp"],
+                srcs = ["src/parallel_lexer.cpp"],
+                deps = ["aparse/lexer",
+                        "aparse/error"],
+                global_link_flags = "-lpthread"),
 
   br.CppLibrary("aparse/lexer_builder",
                 hdrs = ["include/aparse/lexer_builder.hpp"],
                 srcs = ["src/lexer_builder.cpp"],
                 deps = ["aparse/lexer",
                         "src/internal_lexer_builder",
-                        "src/parse_char_regex"]),
+                        "src/parse_char_regex",
+                        "src/helpers"]),
 
   br.CppLibrary("src/internal_lexer_builder",
                 hdrs = ["src/internal_lexer_builder.hpp"],
@@ -201,13 +284,15 @@ configs.dependency_configs = [
                 deps = ["src/lexer_machine_builder",
                         "aparse/error",
                         "aparse/lexer",
-                        "aparse/regex"]),
+                        "aparse/regex"],
+                global_link_flags = "-lpthread"),
 
   br.CppLibrary("src/internal_parser_builder",
                 hdrs = ["src/internal_parser_builder.hpp"],
                 srcs = ["src/internal_parser_builder.cpp"],
                 deps = ["aparse/parser",
                         "src/v2/core_parser",
+                        "src/v2/deterministic_aparse_machine",
                         "toolchain/quick",
                         "src/v2/aparse_machine_builder"]),
 
@@ -217,6 +302,7 @@ configs.dependency_configs = [
                 deps = ["src/v2/aparse_machine",
                         "aparse/error",
                         "src/v2/core_parser",
+                        "src/v2/deterministic_core_parser",
                         "toolchain/quick"]),
 
   br.CppLibrary("src/regex_builder",
@@ -246,6 +332,12 @@ configs.dependency_configs = [
                 deps = ["src/v2/core_parser",
                         "src/v2/aparse_machine_builder"]),
 
+  br.CppTest("src/v2/deterministic_core_parser_integration_test",
+                srcs = ["src/v2/deterministic_core_parser_integration_test.cpp"],
+                deps = ["src/v2/deterministic_core_parser",
+                        "src/v2/core_parser",
+                        "src/v2/aparse_machine_builder"]),
+
   # br.CppTest("tests/bug1_test",
   #               srcs = ["tests/bug1_test.cpp"],
   #               deps = ["src/core_parser",
@@ -279,6 +371,29 @@ configs.dependency_configs = [
                 deps = ["aparse/lexer_builder",
                         "toolchain/quick"]),
 
+  br.CppTest("src/lexer_code_generator_test",
+                srcs = ["src/lexer_code_generator_test.cpp"],
+                deps = ["aparse/lexer_code_generator",
+                        "tests/samples/generated_calc_lexer"]),
+
+  br.CppTest("src/batch_lexer_integration_test",
+                srcs = ["src/batch_lexer_integration_test.cpp"],
+                deps = ["aparse/batch_lexer",
+                        "aparse/lexer_builder",
+                        "toolchain/quick"]),
+
+  br.CppTest("src/incremental_lexer_integration_test",
+                srcs = ["src/incremental_lexer_integration_test.cpp"],
+                deps = ["aparse/incremental_lexer",
+                        "aparse/lexer_builder",
+                        "toolchain/quick"]),
+
+  br.CppTest("src/parallel_lexer_integration_test",
+                srcs = ["src/parallel_lexer_integration_test.cpp"],
+                deps = ["aparse/parallel_lexer",
+                        "aparse/lexer_builder",
+                        "toolchain/quick"]),
+
   br.CppTest("src/parser_builder_integration_test",
                 srcs = ["src/parser_builder_integration_test.cpp"],
                 deps = ["aparse/parser_builder",
@@ -321,6 +436,10 @@ configs.dependency_configs = [
                 srcs = ["src/utils/any_test.cpp"],
                 deps = ["aparse/utils/any"]),
 
+  br.CppProgram("tools/cpp_tools/generate_lexer_cpp",
+                srcs = ["tools/cpp_tools/generate_lexer_cpp.cpp"],
+                deps = ["aparse/lexer_code_generator"]),
+
   br.CppProgram("tools/experiments/parser1",
                 ignore_cpplint = True,
                 srcs = ["tools/experiments/parser1.cpp"],
@@ -368,8 +487,12 @@ def SetCompilerOps(compiler_options):
     configs["CCFLAGS"] += " -O3 " + configs.prod_cc_flags;
   elif (configs.compiler_options["mode"] == "release"):
     configs["CCFLAGS"] += " -O3 " + configs.prod_cc_flags;
+  # aparse::Offset is int64_t instead of int32_t. Refer to
+  # include/aparse/utils/very_common_headers.hpp
+  if (configs.compiler_options.get("offsets64")):
+    configs["CCFLAGS"] += " -DAPARSE_64BIT_OFFSETS ";
 
-SetCompilerOps(dict(mode = "opt"));
+SetCompilerOps(dict(mode = "opt", offsets64 = False));
 
 configs.SetCompilerOps = SetCompilerOps;
 
@@ -24,12 +24,13 @@ def RunLintChecks(configs, files = None):
       filter = (lambda x: x.get("ignore_cpplint") != True));
   infra_lib.RunLinuxCommand(os.path.join(configs.toolchain_path + "/cpplint.py") + " --filter=-build/header_guard,-readability/alt_tokens " + " ".join(files));
 
-def RunAllTests(configs, pp = 8, tests = None):
+def RunAllTests(configs, pp = 8, tests = None, offsets64 = False):
   if (tests == None):
     tests = list(i["name"] for i in configs.dependency_configs if i["type"] == "CppTest")
-  infra_lib.RunLinuxCommand("scons -k -j"+str(pp) + " mode=" + configs.compiler_options.mode + " " + " ".join(tests));
+  build_dir = configs.build_dir + ("-offsets64" if offsets64 else "");
+  infra_lib.RunLinuxCommand("scons -k -j"+str(pp) + " mode=" + configs.compiler_options.mode + " offsets64=" + str(int(offsets64)) + " " + " ".join(tests));
   for i in tests:
-    infra_lib.RunLinuxCommand("./" + configs.build_dir + "/" + i);
+    infra_lib.RunLinuxCommand("./" + build_dir + "/" + i);
 
 def ReplaceAllInFile(str1, str2, file):
   inf.WriteFile(file, inf.ReadFile(file).replace(str1, str2));
@@ -40,7 +40,7 @@ def main():
   if len(sys.argv) == 1:
     return help_message;
   command = sys.argv[1]
-  opts, args = getopt.getopt(sys.argv[2:], "", ["arg1=", "mode=", "=package", "=from"])
+  opts, args = getopt.getopt(sys.argv[2:], "", ["arg1=", "mode=", "offsets64", "=package", "=from"])
   opts = dict(opts);
   print(opts, args);
   if ("--mode" in opts):
@@ -77,10 +77,13 @@ def main():
   elif command == "lint":
     helpers.RunLintChecks(configs, (args if len(args) > 0 else None));
   elif command in ["run_test", "rt"]:
-    helpers.RunAllTests(configs, pp = 8, tests = (args if len(args) > 0 else None));
+    helpers.RunAllTests(configs, pp = 8, tests = (args if len(args) > 0 else None),
+                        offsets64 = ("--offsets64" in opts));
   elif command in ["per_commit_check", "pcc"]:
     helpers.RunLintChecks(configs);
     helpers.RunAllTests(configs, pp = 8);
+    # The 64 bit aparse::Offset variant.
+    helpers.RunAllTests(configs, pp = 8, offsets64 = True);
   else:
     return infra_lib.Exit("Invalid command '" + command + "'");
 